@@ -0,0 +1,148 @@
+#include "Alloc.h"
+
+#if defined(SW_ALLOCS)
+#include <atomic>
+#include <new>
+#include <stdint.h>
+#include <stdlib.h>
+
+thread_local AllocCounts allocCounts;
+
+namespace
+{
+	// every block starts with its size so delete knows how much stopped being live. A full alignment unit keeps
+	// what's handed out as aligned as malloc's
+	const size_t HEADER = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+	std::atomic< size_t > live{0};
+	std::atomic< size_t > peak{0};
+	std::atomic< uint64_t > processCount{0};
+	std::atomic< uint64_t > processBytes{0};
+
+	void* allocate(size_t size)
+	{
+		// the header would wrap a size this big around to a small block
+		if ( size > SIZE_MAX - HEADER )
+		{
+			return nullptr;
+		}
+		char* block = (char*)malloc(size + HEADER);
+		if ( !block )
+		{
+			return nullptr;
+		}
+		*(size_t*)block = size;
+		allocCounts.allocs++;
+		allocCounts.bytes += size;
+		processCount.fetch_add(1, std::memory_order_relaxed);
+		processBytes.fetch_add(size, std::memory_order_relaxed);
+		size_t now = live.fetch_add(size, std::memory_order_relaxed) + size;
+		size_t high = peak.load(std::memory_order_relaxed);
+		while ( now > high && !peak.compare_exchange_weak(high, now, std::memory_order_relaxed) )
+		{
+		}
+
+		return block + HEADER;
+	}
+
+	void release(void* ptr)
+	{
+		if ( !ptr )
+		{
+			return;
+		}
+		char* block = (char*)ptr - HEADER;
+		live.fetch_sub(*(size_t*)block, std::memory_order_relaxed);
+		free(block);
+	}
+}
+
+void* operator new(size_t size)
+{
+	void* ptr = allocate(size);
+	if ( !ptr )
+	{
+		throw std::bad_alloc();
+	}
+
+	return ptr;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return allocate(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	release(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	release(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+	release(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+	release(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+	release(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+	release(ptr);
+}
+
+AllocCounts processAllocs()
+{
+	AllocCounts counts;
+	counts.allocs = processCount.load(std::memory_order_relaxed);
+	counts.bytes = processBytes.load(std::memory_order_relaxed);
+
+	return counts;
+}
+
+size_t liveBytes()
+{
+	return live.load(std::memory_order_relaxed);
+}
+
+size_t allocPeak()
+{
+	return peak.exchange(live.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+#else
+AllocCounts processAllocs()
+{
+	return AllocCounts();
+}
+
+size_t liveBytes()
+{
+	return 0;
+}
+
+size_t allocPeak()
+{
+	return 0;
+}
+#endif
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// built with ALLOCS=TRUE (SW_ALLOCS) the global operator new and delete are replaced with ones that count, so profiler
+// scopes and benchmarks can see how much the code they cover allocates. Otherwise everything here reads zero
+struct AllocCounts
+{
+	uint64_t allocs = 0; // calls to new
+	uint64_t bytes = 0; // asked for by them
+};
+
+#if defined(SW_ALLOCS)
+extern thread_local AllocCounts allocCounts;
+#endif
+
+// running totals for the calling thread, the difference of two is what happened in between
+inline AllocCounts threadAllocs()
+{
+#if defined(SW_ALLOCS)
+	return allocCounts;
+#else
+	return AllocCounts();
+#endif
+}
+
+// the same across every thread, for spans like a whole frame whose work runs on more than one
+AllocCounts processAllocs();
+size_t liveBytes(); // allocated and not yet freed, across all threads
+size_t allocPeak(); // highest liveBytes since the last call, each call starts the next window from the current level
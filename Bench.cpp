@@ -0,0 +1,414 @@
+#include "Game.h"
+#include <chrono>
+#include <iostream>
+#include <string.h>
+
+// microbenchmarks of the entity manager and the game systems at a range of world sizes. Built as its own binary with
+// `make bench`, runs headless and writes JSON (bench.json unless told otherwise), one entry per benchmark and size
+// with every sample kept so runs can be compared statistically
+struct BenchResult
+{
+	std::string name;
+	size_t entities;
+	size_t iterations; // op calls per sample
+	std::vector< double > samples; // nanoseconds per operation
+	uint64_t allocs = 0; // over every sample's timed ops, ALLOCS=TRUE only
+	uint64_t allocBytes = 0;
+	uint64_t ops = 0;
+};
+
+class Benchmarks
+{
+private:
+	const char* m_config;
+	int m_samples;
+	double m_sampleTime; // seconds each sample aims to take
+	const char* m_filter;
+	std::vector< BenchResult > m_results;
+	volatile size_t m_sink = 0; // results that would otherwise be optimised away
+
+	bool wanted(const char* name) const
+	{
+		return !m_filter || strstr(name, m_filter);
+	}
+
+	// enough calls that one sample takes about m_sampleTime, judged from a single timed call
+	size_t calibrate(double seconds, size_t maxIterations) const
+	{
+		size_t iterations = (seconds > 0) ? m_sampleTime / seconds : maxIterations;
+		return (iterations < 1) ? 1 : (iterations > maxIterations) ? maxIterations : iterations;
+	}
+
+	// what was allocated since before, added to the result's totals
+	static void countAllocs(BenchResult& result, const AllocCounts& before, uint64_t ops)
+	{
+		AllocCounts after = threadAllocs();
+		result.allocs += after.allocs - before.allocs;
+		result.allocBytes += after.bytes - before.bytes;
+		result.ops += ops;
+	}
+
+	void report(const BenchResult& result)
+	{
+		std::vector< double > sorted = result.samples;
+		std::sort(sorted.begin(), sorted.end());
+#if defined(SW_ALLOCS)
+		std::cerr << result.name << " @ " << result.entities << ": " << sorted[sorted.size() / 2] << " ns/op, " << result.allocs / (double)result.ops << " allocs/op" << std::endl;
+#else
+		std::cerr << result.name << " @ " << result.entities << ": " << sorted[sorted.size() / 2] << " ns/op" << std::endl;
+#endif
+		m_results.push_back(result);
+	}
+
+	// times op over and over, ops counts the operations one call does so results are per operation
+	template < typename Setup, typename Op >
+	void run(const char* name, size_t entities, size_t ops, Setup setup, Op op, size_t maxIterations = 1 << 20)
+	{
+		if ( !wanted(name) )
+		{
+			return;
+		}
+		BenchResult result = {name, entities, 0, {}};
+		for (int s = 0; s < m_samples; s++)
+		{
+			setup();
+			auto start = std::chrono::steady_clock::now();
+			if ( s == 0 )
+			{
+				op();
+				result.iterations = calibrate(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), maxIterations);
+				setup();
+				start = std::chrono::steady_clock::now();
+			}
+			AllocCounts allocs = threadAllocs();
+			for (size_t i = 0; i < result.iterations; i++)
+			{
+				op();
+			}
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			countAllocs(result, allocs, result.iterations * ops);
+			result.samples.push_back(seconds * 1e9 / (result.iterations * ops));
+		}
+		report(result);
+	}
+
+	// like run() but prepare() is called untimed before every call, for ops that use up what they work on
+	template < typename Setup, typename Prepare, typename Op >
+	void runEach(const char* name, size_t entities, size_t ops, Setup setup, Prepare prepare, Op op, size_t maxIterations = 1 << 20)
+	{
+		if ( !wanted(name) )
+		{
+			return;
+		}
+		BenchResult result = {name, entities, 0, {}};
+		for (int s = 0; s < m_samples; s++)
+		{
+			setup();
+			double seconds = 0;
+			if ( s == 0 )
+			{
+				prepare();
+				auto start = std::chrono::steady_clock::now();
+				op();
+				result.iterations = calibrate(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), maxIterations);
+				setup();
+			}
+			for (size_t i = 0; i < result.iterations; i++)
+			{
+				prepare();
+				AllocCounts allocs = threadAllocs();
+				auto start = std::chrono::steady_clock::now();
+				op();
+				seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				countAllocs(result, allocs, ops);
+			}
+			result.samples.push_back(seconds * 1e9 / (result.iterations * ops));
+		}
+		report(result);
+	}
+
+	// enemies on the left half and debris on the right, bullets in a strip along the bottom and the player in the
+	// middle. Nothing overlaps, so every system does its full amount of checking without the world changing under it
+	static void fillWorld(Game& game, size_t enemies, size_t debris, size_t bullets)
+	{
+		game.m_entities.clear();
+		game.m_player.reset();
+		game.m_player2.reset();
+		game.spawnPlayer();
+		game.m_entities.update();
+		const GameConfig& config = game.config;
+		float width = config.window.width;
+		float height = config.window.height;
+		float r = config.enemy.radius;
+		Rng rng(1, 0);
+		for (size_t i = 0; i < enemies; i++)
+		{
+			auto e = game.m_entities.addEntity("Enemy");
+			Vector2 pos = {(float)rng.range(r, width / 2 - 4 * r), (float)rng.range(r, height - 4 * r)};
+			e->cTransform = std::make_shared< CTransform >(pos, (Vector2) {0, 0});
+			e->cShape = std::make_shared< CShape >(rng.range(3, 8), r, WHITE, config.enemy.o_col, config.enemy.o_thick);
+			e->cCollision = std::make_shared< CCollision >(config.enemy.c_radius);
+			e->cScore = std::make_shared< CScore >(100);
+		}
+		for (size_t i = 0; i < debris; i++)
+		{
+			auto e = game.m_entities.addEntity("Debris");
+			Vector2 pos = {(float)rng.range(width / 2 + 4 * r, width - r), (float)rng.range(r, height - 4 * r)};
+			e->cTransform = std::make_shared< CTransform >(pos, (Vector2) {0, 0});
+			e->cShape = std::make_shared< CShape >(4, r / 3, WHITE, config.enemy.o_col, 1);
+			e->cCollision = std::make_shared< CCollision >(config.enemy.c_radius / 4);
+			e->cScore = std::make_shared< CScore >(200);
+			e->cDuration = std::make_shared< CDuration >(1 << 30, game.m_currentFrame);
+		}
+		for (size_t i = 0; i < bullets; i++)
+		{
+			auto e = game.m_entities.addEntity("Bullet");
+			Vector2 pos = {(float)rng.range(0, width), height - r};
+			e->cTransform = std::make_shared< CTransform >(pos, (Vector2) {0, 0});
+			e->cShape = std::make_shared< CShape >(20, config.bullet.radius, config.bullet.col, config.bullet.o_col, config.bullet.o_thick);
+			e->cCollision = std::make_shared< CCollision >(config.bullet.c_radius);
+			e->cDuration = std::make_shared< CDuration >(1 << 30, game.m_currentFrame);
+		}
+		game.m_entities.update();
+	}
+
+	static void fillBackground(Game& game, size_t count)
+	{
+		EntityManager& entities = game.back.entities;
+		entities.clear();
+		Rng rng(2, 0);
+		for (size_t i = 0; i < count; i++)
+		{
+			auto e = entities.addEntity("Enemy");
+			Vector2 pos = {(float)rng.range(0, game.config.window.width), (float)rng.range(0, game.config.window.height)};
+			e->cTransform = std::make_shared< CTransform >(pos, (Vector2) {1, 1});
+			e->cShape = std::make_shared< CShape >(rng.range(3, 8), game.config.enemy.radius, WHITE, BLACK, 1);
+			e->cDuration = std::make_shared< CDuration >(1 << 30, 0);
+		}
+		entities.update();
+	}
+
+	static void fillManager(EntityManager& entities, size_t count)
+	{
+		static const char* const tags[] = {"Enemy", "Debris", "Bullet", "Label", "Explosion"};
+		entities.clear();
+		for (size_t i = 0; i < count; i++)
+		{
+			entities.addEntity(tags[i % 5]);
+		}
+		entities.update();
+	}
+public:
+	Benchmarks(const char* config, int samples, double sampleTime, const char* filter)
+		: m_config(config), m_samples(samples), m_sampleTime(sampleTime), m_filter(filter) {}
+
+	void runAll(const std::vector< size_t >& sizes)
+	{
+		Game game(m_config, true, 1);
+		for (size_t n : sizes)
+		{
+			EntityManager entities;
+			runEach("EntityManager::addEntity", n, n, [&] {}, [&] { entities.clear(); }, [&] {
+				for (size_t i = 0; i < n; i++)
+				{
+					entities.addEntity("Enemy");
+				}
+				entities.update();
+			}, 1000);
+			for (int churn : {0, 10, 50})
+			{
+				// churn percent of the entities are destroyed and as many added before each update
+				std::string name = "EntityManager::update churn " + std::to_string(churn) + "%";
+				size_t changed = n * churn / 100;
+				runEach(name.c_str(), n, 1, [&] { fillManager(entities, n); }, [&] {
+					EntityVec& all = entities.getEntities();
+					for (size_t i = 0; i < changed && i < all.size(); i++)
+					{
+						entities.removeEntity(all[(i * 7919) % all.size()]);
+					}
+					for (size_t i = 0; i < changed; i++)
+					{
+						entities.addEntity("Debris");
+					}
+				}, [&] { entities.update(); }, 10000);
+			}
+			static const char* const lookups[] = {"Enemy", "Debris", "Bullet", "Label", "Explosion", "Player"};
+			size_t next = 0;
+			run("EntityManager::getEntities(tag)", n, 1, [&] { fillManager(entities, n); }, [&] {
+				m_sink = m_sink + entities.getEntities(lookups[next++ % 6]).size();
+			});
+			entities.clear();
+
+			std::shared_ptr< Entity > enemy;
+			runEach("Game::spawnDebris", n, 1, [&] { fillWorld(game, n / 2, n / 2, 16); }, [&] {
+				enemy = game.m_entities.getEntities("Enemy").front();
+			}, [&] { game.spawnDebris(enemy); }, 2000);
+			enemy.reset();
+			runEach("Game::spawnEnemy", n, 1, [&] { fillWorld(game, n / 2, n / 2, 16); }, [&] {}, [&] { game.spawnEnemy(); }, 2000);
+			run("Game::sCollision", n, 1, [&] { fillWorld(game, n / 2, n / 2, 16); }, [&] { game.sCollision(); }, 100000);
+			run("Game::sDuration", n, 1, [&] { fillWorld(game, n / 2, n / 2, 16); }, [&] { game.sDuration(); }, 100000);
+			run("Background::step", n, 1, [&] { fillBackground(game, n); }, [&] { game.back.step(); }, 100000);
+			game.back.entities.clear();
+
+			// save states of the same world, restoring onto it is the rollback case where every entity is reused
+			WorldState state;
+			WorldState decoded;
+			ByteWriter out;
+			auto fillState = [&] { fillWorld(game, n / 2, n / 2, 16); game.captureState(state); out.clear(); encodeWorld(state, out); };
+			run("Game::captureState", n, 1, fillState, [&] { game.captureState(state); }, 10000);
+			run("Game::restoreState", n, 1, fillState, [&] { game.restoreState(state); }, 10000);
+			run("encodeWorld", n, 1, fillState, [&] { out.clear(); encodeWorld(state, out); }, 10000);
+			run("decodeWorld", n, 1, fillState, [&] {
+				ByteReader in(out.buffer(), out.size());
+				m_sink = m_sink + decodeWorld(in, decoded);
+			}, 10000);
+		}
+	}
+
+	// every sample is a whole run of the scenario, timed per tick. The world changes as it goes so there's no calibrating
+	void runScenarios(const std::vector< std::string >& files, float scale)
+	{
+		if ( files.empty() )
+		{
+			return;
+		}
+		Game game(m_config, true, 1);
+		for (const std::string& file : files)
+		{
+			ScenarioConfig scenario;
+			if ( !parse_scenario(scenario, file.c_str(), scale) )
+			{
+				std::cerr << "could not read scenario " << file << std::endl;
+				continue;
+			}
+			std::string name = "scenario " + scenario.name;
+			if ( !wanted(name.c_str()) || scenario.ticks <= 0 )
+			{
+				continue;
+			}
+			BenchResult result = {name, 0, (size_t)scenario.ticks, {}};
+			for (int s = 0; s < m_samples; s++)
+			{
+				game.loadScenario(scenario);
+				result.entities = game.entityCount();
+				AllocCounts allocs = threadAllocs();
+				auto start = std::chrono::steady_clock::now();
+				for (long t = 0; t < scenario.ticks; t++)
+				{
+					game.step();
+				}
+				double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				countAllocs(result, allocs, scenario.ticks);
+				result.samples.push_back(seconds * 1e9 / scenario.ticks);
+			}
+			report(result);
+		}
+	}
+
+	nlohmann::json json() const
+	{
+		nlohmann::json out;
+		out["benchmarks"] = nlohmann::json::array();
+		for (const BenchResult& result : m_results)
+		{
+			std::vector< double > sorted = result.samples;
+			std::sort(sorted.begin(), sorted.end());
+			nlohmann::json j_bench = {
+				{"name", result.name},
+				{"entities", result.entities},
+				{"iterations", result.iterations},
+				{"median_ns", sorted[sorted.size() / 2]},
+				{"min_ns", sorted.front()},
+				{"samples_ns", result.samples}
+			};
+#if defined(SW_ALLOCS)
+			j_bench["allocs_per_op"] = (result.ops) ? result.allocs / (double)result.ops : 0;
+			j_bench["bytes_per_op"] = (result.ops) ? result.allocBytes / (double)result.ops : 0;
+#endif
+			out["benchmarks"].push_back(j_bench);
+		}
+
+		return out;
+	}
+};
+
+int main(int argc, char* argv[])
+{
+	const char* config = "config.json";
+	const char* out = "bench.json"; // - for stdout, though the game's start up messages go there too
+	const char* filter = nullptr;
+	int samples = 7;
+	double sampleTime = 0.02;
+	std::vector< size_t > sizes = {100, 1000, 10000, 100000};
+	std::vector< std::string > scenarios;
+	float scale = 1;
+	for (int i = 1; i < argc; i++)
+	{
+		if ( strcmp(argv[i], "--config") == 0 && i + 1 < argc )
+		{
+			config = argv[++i];
+		}
+		else if ( strcmp(argv[i], "--out") == 0 && i + 1 < argc )
+		{
+			out = argv[++i];
+		}
+		else if ( strcmp(argv[i], "--filter") == 0 && i + 1 < argc )
+		{
+			filter = argv[++i];
+		}
+		else if ( strcmp(argv[i], "--samples") == 0 && i + 1 < argc )
+		{
+			samples = atoi(argv[++i]);
+			samples = (samples > 0) ? samples : 1;
+		}
+		else if ( strcmp(argv[i], "--sample-time") == 0 && i + 1 < argc )
+		{
+			sampleTime = atof(argv[++i]);
+		}
+		else if ( strcmp(argv[i], "--sizes") == 0 && i + 1 < argc )
+		{
+			// comma separated
+			sizes.clear();
+			for (char* size = strtok(argv[++i], ","); size; size = strtok(nullptr, ","))
+			{
+				sizes.push_back(strtoull(size, nullptr, 10));
+			}
+		}
+		else if ( strcmp(argv[i], "--scenarios") == 0 && i + 1 < argc )
+		{
+			// comma separated scenario files, each timed per tick over whole runs
+			for (char* file = strtok(argv[++i], ","); file; file = strtok(nullptr, ","))
+			{
+				scenarios.push_back(file);
+			}
+		}
+		else if ( strcmp(argv[i], "--scale") == 0 && i + 1 < argc )
+		{
+			scale = atof(argv[++i]);
+		}
+		else
+		{
+			std::cout << "usage: shape_wars_bench [--config file] [--out file] [--filter name] [--samples n] [--sample-time seconds] [--sizes 100,1000,...] [--scenarios file,... [--scale x]]" << std::endl;
+			return 1;
+		}
+	}
+	Benchmarks benchmarks(config, samples, sampleTime, filter);
+	benchmarks.runAll(sizes);
+	benchmarks.runScenarios(scenarios, scale);
+	std::string json = benchmarks.json().dump(1, '\t');
+	if ( strcmp(out, "-") == 0 )
+	{
+		std::cout << json << std::endl;
+		return 0;
+	}
+	std::ofstream file(out, std::ios::trunc);
+	if ( !file )
+	{
+		std::cerr << "could not write " << out << std::endl;
+		return 1;
+	}
+	file << json << std::endl;
+	std::cerr << "wrote " << out << std::endl;
+
+	return 0;
+}
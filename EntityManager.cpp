@@ -18,6 +18,7 @@ void EntityManager::update()
 			new_map[e->tag()].push_back(e);
 		}
 	}
+	m_despawned += m_entities.size() - new_vec.size();
 	if (!m_toAdd.empty())
 	{
 		for (auto a : m_toAdd)
@@ -25,6 +26,7 @@ void EntityManager::update()
 			new_vec.push_back(a);
 			new_map[a->tag()].push_back(a);
 		}
+		m_spawned += m_toAdd.size();
 		m_toAdd.clear();
 	}
 	m_entities = new_vec;
@@ -38,6 +40,7 @@ void EntityManager::removeEntity(std::shared_ptr<Entity> entity)
 
 void EntityManager::clear()
 {
+	m_despawned += m_entities.size(); // pending ones were never counted as spawned
 	m_entities.clear();
 	m_toAdd.clear();
 	m_entityMap.clear();
@@ -60,3 +63,88 @@ EntityVec & EntityManager::getEntities(const std::string & tag)
 {
 	return m_entityMap[tag];
 }
+
+size_t EntityManager::spawned() const
+{
+	return m_spawned;
+}
+
+size_t EntityManager::despawned() const
+{
+	return m_despawned;
+}
+
+EntityVec & EntityManager::getPending()
+{
+	return m_toAdd;
+}
+
+size_t EntityManager::getTotal() const
+{
+	return m_totalEntities;
+}
+
+std::shared_ptr<Entity> EntityManager::makeEntity(size_t id, const std::string & tag, bool active)
+{
+	// not tracked until it is passed to restore()
+	return std::shared_ptr<Entity>(new Entity(id, tag, active));
+}
+
+void EntityManager::setActive(const std::shared_ptr<Entity> & entity, bool active)
+{
+	entity->m_active = active;
+}
+
+void EntityManager::restore(EntityVec & entities, EntityVec & pending, size_t total, size_t kept, const std::vector<uint8_t> & tags, const std::vector<std::string> & names)
+{
+	// the ticks being undone are simulated again and count their spawns and despawns again, so take back the ones that
+	// show: entities live now but not in the state were spawned since, and ones in the state but not live now despawned
+	// since
+	size_t spawnedSince = m_entities.size() - kept;
+	size_t despawnedSince = entities.size() - kept;
+	m_spawned -= spawnedSince;
+	if (despawnedSince <= m_despawned)
+	{
+		m_despawned -= despawnedSince;
+	}
+	else
+	{
+		// a saved game loaded into a world that never had its entities, they join as spawned
+		m_spawned += despawnedSince - m_despawned;
+		m_despawned = 0;
+	}
+	m_entities.swap(entities);
+	m_toAdd.swap(pending);
+	m_totalEntities = total;
+	// rolling back usually leaves most of each tag's list as it was. Entries are only replaced from the first one that
+	// differs, so the unchanged ones don't pay for a reference count going down and straight back up
+	std::vector< std::pair<EntityVec *, size_t> > lists(names.size(), std::make_pair(nullptr, 0));
+	for (size_t i = 0; i < m_entities.size(); i++)
+	{
+		auto & tagged = lists[tags[i]];
+		if (!tagged.first)
+		{
+			tagged.first = &m_entityMap[names[tags[i]]];
+		}
+		EntityVec & list = *tagged.first;
+		if (tagged.second < list.size() && list[tagged.second] == m_entities[i])
+		{
+			tagged.second++;
+			continue;
+		}
+		list.resize(tagged.second++);
+		list.push_back(m_entities[i]);
+	}
+	for (auto & tagged : m_entityMap)
+	{
+		size_t kept = 0;
+		for (auto & known : lists)
+		{
+			if (known.first == &tagged.second)
+			{
+				kept = known.second;
+			}
+		}
+		tagged.second.resize(kept);
+	}
+}
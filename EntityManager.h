@@ -12,6 +12,8 @@ private:
 	EntityVec m_toAdd;
 	std::map<std::string, EntityVec> m_entityMap;
 	size_t m_totalEntities = 0;
+	size_t m_spawned = 0; // entities that have joined the list in update(), ever
+	size_t m_despawned = 0;
 public:
 	EntityManager();
 	void update();
@@ -20,4 +22,14 @@ public:
 	std::shared_ptr<Entity> addEntity(const std::string & tag);
 	EntityVec & getEntities();
 	EntityVec & getEntities(const std::string & tag);
+	size_t spawned() const;
+	size_t despawned() const;
+	// saved games
+	EntityVec & getPending();
+	size_t getTotal() const;
+	std::shared_ptr<Entity> makeEntity(size_t id, const std::string & tag, bool active = true);
+	void setActive(const std::shared_ptr<Entity> & entity, bool active);
+	// takes the contents of both vectors. tags holds each entity's index into names, so the tag lists are rebuilt
+	// without reading every entity. kept is how many of the live entities are also live in entities
+	void restore(EntityVec & entities, EntityVec & pending, size_t total, size_t kept, const std::vector<uint8_t> & tags, const std::vector<std::string> & names);
 };
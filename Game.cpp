@@ -7,6 +7,10 @@ bool parse_config(GameConfig& config, const char* file)
 		std::ifstream input(file);
 		nlohmann::json j_settings;
 		input >> j_settings;
+		if ( j_settings.contains("Seed") )
+		{
+			config.seed = j_settings["Seed"];
+		}
 		parse_window(config.window, j_settings);
 		parse_font(config.font, j_settings);
 		parse_player(config.player, j_settings);
@@ -82,6 +86,53 @@ void parse_bullet(BulletConfig& config, const nlohmann::json& json)
 	config.duration = config.duration * fps / 1000;
 }
 
+bool parse_scenario(ScenarioConfig& scenario, const char* file, float scale)
+{
+	if ( !FileExists(file) )
+	{
+		return false;
+	}
+	std::ifstream input(file);
+	nlohmann::json j_scenario;
+	input >> j_scenario;
+	scenario.name = (j_scenario.contains("Name")) ? j_scenario["Name"].get< std::string >() : std::string(file);
+	if ( j_scenario.contains("Ticks") )
+	{
+		scenario.ticks = j_scenario["Ticks"];
+	}
+	if ( j_scenario.contains("Seed") )
+	{
+		scenario.seed = j_scenario["Seed"];
+	}
+	if ( j_scenario.contains("Enemies") )
+	{
+		scenario.enemies = (int)j_scenario["Enemies"] * scale;
+	}
+	if ( j_scenario.contains("Bombs") )
+	{
+		scenario.bombs = (int)j_scenario["Bombs"] * scale;
+	}
+	if ( j_scenario.contains("Fuse") )
+	{
+		scenario.fuse[0] = j_scenario["Fuse"][0];
+		scenario.fuse[1] = j_scenario["Fuse"][1];
+	}
+	if ( j_scenario.contains("Bursts") )
+	{
+		scenario.bursts = (int)j_scenario["Bursts"] * scale;
+	}
+	if ( j_scenario.contains("BurstSides") )
+	{
+		scenario.burstSides = j_scenario["BurstSides"];
+	}
+	if ( j_scenario.contains("Spawner") )
+	{
+		scenario.spawner = j_scenario["Spawner"];
+	}
+	
+	return true;
+}
+
 int Background::addCol(const Color& col)
 {
 	colours.push_back(col);
@@ -162,7 +213,7 @@ void Background::step()
 			}
 			if (framesAlive >= e->cDuration->frames)
 			{
-				std::cout << "despawning " << e->tag() << " " << e->id() << std::endl;
+				SW_DEBUG("despawning %s %zu", e->tag().c_str(), e->id());
 				entities.removeEntity(e); // is buffered so it won't invalidate our iterator
 			}
 		}
@@ -170,9 +221,33 @@ void Background::step()
 	frames++;
 }
 
-void Background::draw()
+void Background::move(float dt)
+{
+	for (auto e : entities.getEntities())
+	{
+		if (e->cTransform)
+		{
+			e->cTransform->pos.x += e->cTransform->velocity.x * dt;
+			e->cTransform->pos.y += e->cTransform->velocity.y * dt;
+			if (e->cShape)
+			{
+				// full rotation every 4 seconds
+				e->cTransform->rotation += 90.0 * dt;
+			}
+		}
+	}
+}
+
+void Background::snapshot(RenderSnapshot& frame)
 {
-	ClearBackground(currCol);
+	frame.background = currCol;
+	for (auto e : entities.getEntities())
+	{
+		if (e->cTransform && e->cShape)
+		{
+			frame.addShape(e->cTransform->pos, e->cTransform->rotation, e->cShape->sides, e->cShape->radius, e->cShape->colour, e->cShape->outlineC, e->cShape->outlineW);
+		}
+	}
 }
 
 void Background::spawner()
@@ -181,7 +256,7 @@ void Background::spawner()
 	size_t spawnRate = 45 - 15 * (enemyConfig.spawn - 1);
 	if ( frames % spawnRate == 0)
 	{
-		std::cout << "Spawning Background Enemy" << std::endl;
+		SW_DEBUG("Spawning Background Enemy");
 		spawnEntity();
 	}
 }
@@ -190,66 +265,509 @@ void Background::spawnEntity()
 {
 	auto enemy = entities.addEntity("Enemy");
 	float diameter = enemyConfig.radius * 2;
-	Color fill = (Color) {static_cast<unsigned char>(GetRandomValue(0, 255)), static_cast<unsigned char>(GetRandomValue(0, 255)), static_cast<unsigned char>(GetRandomValue(0, 255)), 255};
-	float posX = GetRandomValue(diameter, (GetScreenWidth() - diameter));
-	float posY = GetRandomValue(diameter, (GetScreenHeight() - diameter));
+	int rgb[3];
+	rng.range(rgb, 3, 0, 255);
+	Color fill = (Color) {static_cast<unsigned char>(rgb[0]), static_cast<unsigned char>(rgb[1]), static_cast<unsigned char>(rgb[2]), 255};
+	float posX = rng.range(diameter, (windowConfig.width - diameter));
+	float posY = rng.range(diameter, (windowConfig.height - diameter));
 	Vector2 pos = (Vector2) {posX, posY};
-	float randNum1 = static_cast <float> (rand());
-	float randNum2 = static_cast <float> (rand());
-	float divisor = static_cast <float> (RAND_MAX/ (enemyConfig.speed * 2));
-	Vector2 vel = (Vector2){randNum1 / divisor - enemyConfig.speed, randNum2 / divisor - enemyConfig.speed};
-	enemy->cTransform = std::make_shared<CTransform>(pos, vel);
-	enemy->cShape = std::make_shared<CShape>(GetRandomValue(3, 8), enemyConfig.radius, fill, enemyConfig.o_col, enemyConfig.o_thick);
+	float vel[2];
+	rng.uniform(vel, 2, -enemyConfig.speed, enemyConfig.speed);
+	enemy->cTransform = std::make_shared<CTransform>(pos, (Vector2) {vel[0], vel[1]});
+	enemy->cShape = std::make_shared<CShape>(rng.range(3, 8), enemyConfig.radius, fill, enemyConfig.o_col, enemyConfig.o_thick);
 	enemy->cDuration = std::make_shared< CDuration >(enemyConfig.d_life, frames);
 }
 
 void Game::run()
 {
+	PROFILE_SCOPE(PROF_FRAME);
+#if defined(SW_PROFILE)
+	// the simulation isn't running between frames, so its timings can be read here
+	if ( !m_headless && IsKeyPressed(KEY_F3) )
+	{
+		m_showProfile = !m_showProfile;
+	}
+#if defined(SW_ALLOCS)
+	m_profiler.recordHeap(allocPeak());
+#endif
+	if ( m_showProfile )
+	{
+		m_profiler.update();
+	}
+#endif
+	// start to start, so waiting on vsync or the other player counts too
+	auto now = std::chrono::steady_clock::now();
+	if ( m_lastFrame != std::chrono::steady_clock::time_point() )
+	{
+		uint64_t micros = std::chrono::duration_cast< std::chrono::microseconds >(now - m_lastFrame).count();
+		if ( m_frameTimes.frame(micros) )
+		{
+			captureHitch(micros);
+			now = std::chrono::steady_clock::now(); // writing it out isn't the next frame's fault
+		}
+	}
+	m_lastFrame = now;
+	if ( m_metrics && now - m_lastPublish >= std::chrono::milliseconds(METRICS_INTERVAL_MS) )
+	{
+		sMetrics();
+		m_lastPublish = now;
+	}
+	if ( m_watch )
+	{
+		watchStep();
+		return;
+	}
+	if ( m_net )
+	{
+		InputFrame local = (m_headless) ? InputFrame() : pollInput();
+#if !defined(PLATFORM_WEB)
+		// headless games have nothing to draw while they wait for the other player
+		while ( !netStep(local) && m_headless )
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+#endif
+		sSnapshot();
+		m_frames.swap();
+		if ( !m_headless )
+		{
+			sRender();
+		}
+		return;
+	}
+	InputFrame input;
+	if ( !nextInput(input) )
+	{
+		return;
+	}
+	sInput(input);
+	if ( m_headless )
+	{
+		// nothing to draw or poll, just step as fast as possible
+		step();
+		m_frames.swap();
+		return;
+	}
+	if ( m_speed > 1 )
+	{
+		fastForward(input);
+		return;
+	}
+	beginStep(); // simulate this frame while the previous one is drawn
+	sRender();
+	endStep();
+	m_frames.swap();
+}
+
+// the next tick's input from the replay or the keyboard and mouse, logged if we're recording.
+// Repeats keep the buttons held this frame but drop the pause press, so P doesn't toggle once per fast forwarded tick
+bool Game::nextInput(InputFrame& input, bool repeat)
+{
+	if ( m_playback )
+	{
+		input = InputFrame();
+		if ( !m_playback->next(input) )
+		{
+			m_replayDone = true;
+			if ( m_headless )
+			{
+				return false;
+			}
+		}
+	}
+	else if ( repeat )
+	{
+		input.buttons &= ~INPUT_PAUSE;
+	}
+	else if ( !m_headless )
+	{
+		input = pollInput();
+	}
+	m_frameTimes.input(input);
+	if ( m_recorder )
+	{
+		m_recorder->push(input);
+		if ( m_recorder->ticks() % config.window.fps == 0 )
+		{
+			m_recorder->flush();
+		}
+	}
+	
+	return true;
+}
+
+// time dilation, the whole batch of ticks runs back to back on this thread and only the last one is drawn
+void Game::fastForward(InputFrame input)
+{
+	simulate();
+	for (int i = 1; i < m_speed; i++)
+	{
+		nextInput(input, true);
+		sInput(input);
+		simulate();
+	}
+	sSnapshot();
+	m_frames.swap();
+	sRender();
+}
+
+// lockstep with rollback. Our input is used on the tick it's pressed along with a guess at theirs, and when their real
+// input turns out to differ from a guess we rewind to that tick and simulate forward again. Returns false without
+// simulating when we're as far ahead of them as the history can rewind
+bool Game::netStep(InputFrame local)
+{
+	local.buttons &= ~INPUT_PAUSE; // nobody gets to pause the other player
+	m_net->poll();
+	size_t wrong = m_net->mispredicted();
+	if ( wrong < m_netTick )
+	{
+		size_t depth = m_netTick - wrong;
+		if ( m_netHistory.rewind(depth, m_netState) )
+		{
+			m_netHistory.drop(depth);
+			restoreState(m_netState);
+			for (size_t t = wrong; t < m_netTick; t++)
+			{
+				netSimulate(t);
+			}
+			m_rollbacks++;
+			m_resimulated += depth;
+			m_deepestRollback = (depth > m_deepestRollback) ? depth : m_deepestRollback;
+		}
+		else
+		{
+			SW_WARN("could not roll back %zu ticks, the games have diverged", depth);
+		}
+	}
+	if ( m_netTick + 1 >= m_net->confirmed() + m_netHistory.capacity() )
+	{
+		return false;
+	}
+	m_net->pushLocal(local);
+	m_frameTimes.input(local);
+	netSimulate(m_netTick++);
+	
+	return true;
+}
+
+// one tick of a two player game, saved so it can be rewound to
+void Game::netSimulate(size_t tick)
+{
+	InputFrame mine = m_net->local(tick);
+	InputFrame theirs = m_net->remote(tick);
+	sInput((m_net->slot() == 0) ? mine : theirs);
+	sInput2((m_net->slot() == 0) ? theirs : mine);
+	simulate();
+	captureState(m_netState);
+	m_netHistory.push(m_netState);
+}
+
+void Game::startNet()
+{
+	m_twoPlayer = true;
+	reset(m_net->seed());
+	back.entities.clear();
+	setPause(false);
+	m_menu = false;
+	m_netTick = 0;
+	m_netHistory.clear();
+	captureState(m_netState);
+	m_netHistory.push(m_netState);
+}
+
+void Game::reset(uint64_t seed)
+{
+	SW_INFO("seeding RNG with %llu", (unsigned long long)seed);
+	m_seed = seed;
+	m_spawnRng.seed(m_seed, RNG_SPAWN);
+	m_labelRng.seed(m_seed, RNG_LABEL);
+	back.rng.seed(m_seed, RNG_BACKGROUND);
+	m_entities.clear();
+	m_score = 0;
+	m_highScore = 0;
+	m_currentFrame = 0;
+	m_deaths = 0;
+	spawnPlayer();
+}
+
+void Game::step()
+{
+	simulate();
+	sSnapshot();
+}
+
+// one tick of game logic, without building a render snapshot
+void Game::simulate()
+{
+	if ( m_menu )
+	{
+		PROFILE_SCOPE(PROF_BACKGROUND);
+		back.step();
+		back.spawner();
+		back.move(1.0f / (float)(config.window.fps));
+	}
 	if ( !m_paused )
 	{
-		m_entities.update();
-		sEnemySpawner();
+		{
+			PROFILE_SCOPE(PROF_UPDATE);
+			m_entities.update();
+		}
+		if ( m_spawner )
+		{
+			sEnemySpawner();
+		}
 		sMove();
 		sCollision();
 		sDuration();
 		m_currentFrame++;
 	}
-	sInput();
-	sRender();
+	sTransform();
+	m_ticks++;
+#if defined(SW_PROFILE)
+	if ( m_trace )
+	{
+		sTraceCounters();
+	}
+#endif
+}
+
+// every tag the game uses, for counting entities by kind
+static const char* const entityTags[] = {"Player", "Enemy", "Bullet", "Bomb", "Debris", "Explosion", "Label"};
+
+#if defined(SW_PROFILE)
+// what the world looked like this tick, next to the spans
+void Game::sTraceCounters()
+{
+	for (const char* tag : entityTags)
+	{
+		m_trace->counter("entities", tag, m_entities.getEntities(tag).size());
+	}
+	m_trace->counter("entities", "Background", back.entities.getEntities().size());
+	m_trace->counter("collision pairs", nullptr, m_collisionPairs);
+	m_trace->counter("spawns", nullptr, m_entities.spawned() - m_tracedSpawns);
+	m_trace->counter("despawns", nullptr, m_entities.despawned() - m_tracedDespawns);
+	m_tracedSpawns = m_entities.spawned();
+	m_tracedDespawns = m_entities.despawned();
+}
+#endif
+
+#if !defined(PLATFORM_WEB)
+void Game::simLoop()
+{
+#if defined(SW_PROFILE)
+	nameTraceThread("simulation");
+#endif
+	std::unique_lock<std::mutex> lock(m_simLock);
+	while ( true )
+	{
+		m_simSignal.wait(lock, [this] { return m_simPending || m_simQuit; });
+		if ( m_simQuit )
+		{
+			break;
+		}
+		lock.unlock();
+		step();
+		lock.lock();
+		m_simPending = false;
+		m_simSignal.notify_all();
+	}
+}
+#endif
+
+void Game::beginStep()
+{
+#if defined(PLATFORM_WEB)
+	step(); // no threads on the web, simulate inline
+#else
+	{
+		std::lock_guard<std::mutex> lock(m_simLock);
+		m_simPending = true;
+	}
+	m_simSignal.notify_all();
+#endif
+}
+
+void Game::endStep()
+{
+#if !defined(PLATFORM_WEB)
+	std::unique_lock<std::mutex> lock(m_simLock);
+	m_simSignal.wait(lock, [this] { return !m_simPending; });
+#endif
 }
 
 void Game::sMove()
 {
-	m_player->cTransform->velocity.x = 0;
-	m_player->cTransform->velocity.y = 0;
+	PROFILE_SCOPE(PROF_MOVE);
+	movePlayer(*m_player);
+	if ( m_player2 )
+	{
+		movePlayer(*m_player2);
+	}
+}
+
+void Game::movePlayer(Entity& player)
+{
+	player.cTransform->velocity.x = 0;
+	player.cTransform->velocity.y = 0;
 	// Up/Down
-	if (m_player->cInput->up && !m_player->cInput->down)
+	if (player.cInput->up && !player.cInput->down)
 	{
-		m_player->cTransform->velocity.y = -1 * config.player.speed;
+		player.cTransform->velocity.y = -1 * config.player.speed;
 	}
-	if (m_player->cInput->down && !m_player->cInput->up)
+	if (player.cInput->down && !player.cInput->up)
 	{
-		m_player->cTransform->velocity.y = config.player.speed;
+		player.cTransform->velocity.y = config.player.speed;
 	}
 	// Left/Right
-	if (m_player->cInput->left && !m_player->cInput->right)
+	if (player.cInput->left && !player.cInput->right)
 	{
-		m_player->cTransform->velocity.x = -1 * config.player.speed;
+		player.cTransform->velocity.x = -1 * config.player.speed;
 	}
-	if (m_player->cInput->right && !m_player->cInput->left)
+	if (player.cInput->right && !player.cInput->left)
 	{
-		m_player->cTransform->velocity.x = config.player.speed;
+		player.cTransform->velocity.x = config.player.speed;
 	}
 	// Diagonal
-	if (m_player->cTransform->velocity.x != 0 && m_player->cTransform->velocity.y != 0)
+	if (player.cTransform->velocity.x != 0 && player.cTransform->velocity.y != 0)
+	{
+		player.cTransform->velocity.x *= cos(45);
+		player.cTransform->velocity.y *= sin(45);
+	}
+}
+
+void Game::sTransform()
+{
+	PROFILE_SCOPE(PROF_TRANSFORM);
+	for (auto e : m_entities.getEntities())
+	{
+		if (e->cTransform)
+		{
+			if (!m_paused)
+			{
+				float posUpdateX = e->cTransform->velocity.x * (1.0f / (float)(config.window.fps));
+				float posUpdateY = e->cTransform->velocity.y * (1.0f / (float)(config.window.fps));
+				if (e->cDash)
+				{
+					if (e->cDash->active)
+					{
+						posUpdateX *= e->cDash->speedMod;
+						posUpdateY *= e->cDash->speedMod;
+					}
+				}
+				e->cTransform->pos.x += posUpdateX;
+				e->cTransform->pos.y += posUpdateY;
+			}
+			if (e->cShape)
+			{
+				// full rotation every 4 seconds
+				e->cTransform->rotation += 90.0 / (float) config.window.fps;
+			}
+		}
+	}
+}
+
+void Game::sSnapshot()
+{
+	PROFILE_SCOPE(PROF_SNAPSHOT);
+	RenderSnapshot& frame = m_frames.back();
+	frame.clear();
+	back.snapshot(frame);
+	for (auto e : m_entities.getEntities())
+	{
+		if (e->cTransform)
+		{
+			if (e->cShape)
+			{
+				frame.addShape(e->cTransform->pos, e->cTransform->rotation, e->cShape->sides, e->cShape->radius, e->cShape->colour, e->cShape->outlineC, e->cShape->outlineW);
+			}
+			if (e->cLabel)
+			{
+				frame.addLabel(e->cTransform->pos, e->cLabel->text, e->cLabel->size, e->cLabel->colour);
+			}
+		}
+	}
+	frame.cull((Rectangle) {0, 0, (float)config.window.width, (float)config.window.height});
+#if defined(SW_PROFILE)
+	if ( m_trace )
+	{
+		m_trace->counter("shapes", "drawn", frame.stats.shapes);
+		m_trace->counter("shapes", "culled", frame.stats.culled);
+	}
+#endif
+	frame.score = m_score;
+	frame.highScore = m_highScore;
+	frame.seconds = m_currentFrame / config.window.fps;
+	frame.paused = m_paused;
+	frame.tick = m_currentFrame;
+	if ( m_spectators )
+	{
+		sSpectate();
+	}
+}
+
+void Game::sSpectate()
+{
+	// same entities as the snapshot. Game ids get the top bit so they sort, and draw, after the background's
+	m_spectated.clear();
+	for (auto e : back.entities.getEntities())
+	{
+		if (e->cTransform && e->cShape)
+		{
+			m_spectated.addShape(e->id(), e->cTransform->pos, e->cTransform->rotation, e->cShape->sides, e->cShape->radius, e->cShape->colour, e->cShape->outlineC, e->cShape->outlineW);
+		}
+	}
+	for (auto e : m_entities.getEntities())
+	{
+		if (e->cTransform && e->cShape)
+		{
+			m_spectated.addShape(e->id() | 0x80000000u, e->cTransform->pos, e->cTransform->rotation, e->cShape->sides, e->cShape->radius, e->cShape->colour, e->cShape->outlineC, e->cShape->outlineW);
+		}
+		else if (e->cTransform && e->cLabel)
+		{
+			int text = std::find(m_labels.begin(), m_labels.end(), e->cLabel->text) - m_labels.begin();
+			m_spectated.addLabel(e->id() | 0x80000000u, e->cTransform->pos, text, e->cLabel->size, e->cLabel->colour);
+		}
+	}
+	const RenderSnapshot& frame = m_frames.back();
+	m_spectated.background = paletteIndex(frame.background);
+	m_spectated.score = frame.score;
+	m_spectated.highScore = frame.highScore;
+	m_spectated.seconds = frame.seconds;
+	m_spectators->publish(m_spectated);
+}
+
+// a viewer's frame: draw the newest thing the stream sent. Headless viewers wait for it instead
+void Game::watchStep()
+{
+	bool fresh = m_watch->poll();
+#if !defined(PLATFORM_WEB)
+	while ( m_headless && !fresh && m_watch->connected() )
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		fresh = m_watch->poll();
+	}
+#endif
+	if ( fresh )
+	{
+		RenderSnapshot& frame = m_frames.back();
+		m_watch->frame().draw(frame, m_labels);
+		frame.cull((Rectangle) {0, 0, (float)config.window.width, (float)config.window.height});
+		m_frames.swap();
+		m_ticks++;
+	}
+	if ( !m_watch->connected() )
+	{
+		m_replayDone = true;
+	}
+	if ( !m_headless )
 	{
-		m_player->cTransform->velocity.x *= cos(45);
-		m_player->cTransform->velocity.y *= sin(45);
+		sRender();
 	}
 }
 
 void Game::sDuration()
 {
+	PROFILE_SCOPE(PROF_DURATION);
 	for (auto e : m_entities.getEntities())
 	{
 		if (e->cDuration)
@@ -289,9 +807,9 @@ void Game::sDuration()
 		}
 		if (e->cDash)
 		{
-			if (e->cDash->active && m_currentFrame >= m_player->cDash->frameStarted + m_player->cDash->frames)
+			if (e->cDash->active && m_currentFrame >= e->cDash->frameStarted + e->cDash->frames)
 			{
-				std::cout << "Dash has cooled down" << std::endl;
+				SW_DEBUG("Dash has cooled down");
 				e->cDash->active = false;
 			}
 		}
@@ -300,140 +818,125 @@ void Game::sDuration()
 
 void Game::sEnemySpawner()
 {
+	PROFILE_SCOPE(PROF_SPAWNER);
 	// increase spawn rate by .5 second every 30 secs with a max spawnrate of .1 second and a base spawnrate of 3 / config value seconds
 	// TODO: add these settings in config??
 	int spawnRate = 3000 - 500 * (m_currentFrame / config.window.fps / 30);
 	int maxRate = 100;
 	if ( int(m_currentFrame * 1000 * config.enemy.spawn / config.window.fps) % ((spawnRate > maxRate) ? spawnRate : maxRate) == 0)
 	{
-		std::cout << "Spawning Enemy" << std::endl;
+		SW_DEBUG("Spawning Enemy");
 		spawnEnemy();
 	}
 }
 
-void Game::sInput()
+InputFrame Game::pollInput()
 {
+	InputFrame input;
 	if ( IsKeyPressed(KEY_P) || m_overlay.getPage()->getElement(0)->getFocus() )
 	{
 		m_overlay.getPage()->getElement(0)->setFocus(false);
-		back.entities.clear();
-		togglePause();
+		input.buttons |= INPUT_PAUSE;
 	}
 	if ( m_overlay.getPage()->getElement(1)->getFocus() )
 	{
 		m_overlay.getPage()->getElement(1)->setFocus(false);
-		setPause(true);
-	}
-	m_player->cInput->up = IsKeyDown(KEY_W) || IsKeyDown(KEY_UP);
-	m_player->cInput->down = IsKeyDown(KEY_S) || IsKeyDown(KEY_DOWN);
-	m_player->cInput->left = IsKeyDown(KEY_A) || IsKeyDown(KEY_LEFT);
-	m_player->cInput->right = IsKeyDown(KEY_D) || IsKeyDown(KEY_RIGHT);
-	m_player->cInput->dash = IsKeyDown(KEY_SPACE);
-	m_player->cInput->shoot = IsMouseButtonDown(MOUSE_LEFT_BUTTON);
-	m_player->cInput->special = IsMouseButtonDown(MOUSE_RIGHT_BUTTON);
+		// pausing a running game has to go through the input log, re-pausing a paused one only touches the menu
+		if ( m_paused )
+		{
+			setPause(true);
+		}
+		else
+		{
+			input.buttons |= INPUT_PAUSE;
+		}
+	}
+	input.buttons |= (IsKeyDown(KEY_W) || IsKeyDown(KEY_UP)) ? INPUT_UP : 0;
+	input.buttons |= (IsKeyDown(KEY_S) || IsKeyDown(KEY_DOWN)) ? INPUT_DOWN : 0;
+	input.buttons |= (IsKeyDown(KEY_A) || IsKeyDown(KEY_LEFT)) ? INPUT_LEFT : 0;
+	input.buttons |= (IsKeyDown(KEY_D) || IsKeyDown(KEY_RIGHT)) ? INPUT_RIGHT : 0;
+	input.buttons |= IsKeyDown(KEY_SPACE) ? INPUT_DASH : 0;
+	input.buttons |= IsMouseButtonDown(MOUSE_LEFT_BUTTON) ? INPUT_SHOOT : 0;
+	input.buttons |= IsMouseButtonDown(MOUSE_RIGHT_BUTTON) ? INPUT_SPECIAL : 0;
+	if ( input.held(INPUT_SHOOT) )
+	{
+		// bullets are aimed at whole pixels so a replay aims exactly the same way
+		Vector2 mouse = GetMousePosition();
+		input.mouseX = (int16_t)mouse.x;
+		input.mouseY = (int16_t)mouse.y;
+	}
+	
+	return input;
+}
+
+void Game::sInput(const InputFrame& input)
+{
+	if ( input.held(INPUT_PAUSE) )
+	{
+		back.entities.clear();
+		togglePause();
+	}
+	applyInput(m_player, input);
+	if ( !m_headless )
+	{
+		m_menu = m_overlay.getPage(0)->isActive();
+	}
+}
+
+// the second player's buttons, they can't pause
+void Game::sInput2(const InputFrame& input)
+{
+	if ( m_player2 )
+	{
+		applyInput(m_player2, input);
+	}
+}
+
+void Game::applyInput(std::shared_ptr<Entity> player, const InputFrame& input)
+{
+	player->cInput->up = input.held(INPUT_UP);
+	player->cInput->down = input.held(INPUT_DOWN);
+	player->cInput->left = input.held(INPUT_LEFT);
+	player->cInput->right = input.held(INPUT_RIGHT);
+	player->cInput->dash = input.held(INPUT_DASH);
+	player->cInput->shoot = input.held(INPUT_SHOOT);
+	player->cInput->special = input.held(INPUT_SPECIAL);
 	if ( !m_paused )
 	{
-		if (m_player->cInput->shoot && m_entities.getEntities("Bullet").empty())
+		// one bullet in the air per player
+		if (player->cInput->shoot && m_entities.getEntities("Bullet").size() < ((m_player2) ? 2 : 1))
 		{
-			spawnBullet(GetMousePosition());
+			spawnBullet(*player, (Vector2) {(float)input.mouseX, (float)input.mouseY});
 		}
-		if (m_player->cInput->special)
+		if (player->cInput->special)
 		{
-			spawnSpecial();
+			spawnSpecial(*player);
 		}
-		if (m_player->cInput->dash && !(m_player->cDash->active) && m_currentFrame >= m_player->cDash->frameStarted + m_player->cDash->frames + m_player->cDash->delay)
+		if (player->cInput->dash && !(player->cDash->active) && m_currentFrame >= player->cDash->frameStarted + player->cDash->frames + player->cDash->delay)
 		{
-			std::cout << "Dashing!" << std::endl;
-			m_player->cDash->active = true;
-			m_player->cDash->frameStarted = m_currentFrame;
+			SW_DEBUG("Dashing!");
+			player->cDash->active = true;
+			player->cDash->frameStarted = m_currentFrame;
 		}
 	}
 }
 
 void Game::sRender()
 {
+	const RenderSnapshot& frame = m_frames.front();
 	BeginDrawing();
-		if ( m_overlay.getPage(0)->isActive() )
 		{
-			back.step();
-			back.spawner();
-			for (auto e : back.entities.getEntities())
-			{
-				if (e->cTransform)
-				{
-					float posUpdateX = e->cTransform->velocity.x * (1.0f / (float)(config.window.fps));
-					float posUpdateY = e->cTransform->velocity.y * (1.0f / (float)(config.window.fps));
-					e->cTransform->pos.x += posUpdateX;
-					e->cTransform->pos.y += posUpdateY;
-				}
-				if (e->cShape)
-				{
-					DrawPoly(e->cTransform->pos, e->cShape->sides, e->cShape->radius, e->cTransform->rotation, e->cShape->colour);
-					for (int i = 0; i < e->cShape->outlineW; i++)
-					{
-						DrawPolyLines(e->cTransform->pos, e->cShape->sides, e->cShape->radius + i, e->cTransform->rotation, e->cShape->outlineC);
-					}
-					// full rotation every 4 seconds
-					e->cTransform->rotation += 90.0 / (float) config.window.fps;
-				}
-			}
+			// EndDrawing waits out the rest of the frame, which isn't the renderer's time
+			PROFILE_SCOPE(PROF_RENDER);
+			m_renderer.draw(frame);
 		}
-		back.draw();
-		// C style string fuckery
-		char scoreText[28] = "SCORE: ";
-		char scoreNum[21];
-		sprintf(scoreNum, "%d", m_score);
-		strcat(scoreText, scoreNum);
-		Vector2 scorePos = (Vector2) {8, config.font.size + 2};
-		char highScoreText[33] = "HIGH SCORE: ";
-		char highScoreNum[21];
-		sprintf(highScoreNum, "%d", m_highScore);
-		strcat(highScoreText, highScoreNum);
-		Vector2 highScorePos = (Vector2) {8, config.font.size * 2 + 2};
-		char timeText[28] = "TIME: ";
-		char timeNum[21];
-		sprintf(timeNum, "%d", m_currentFrame / config.window.fps);
-		strcat(timeText, timeNum);
-		Vector2 timePos = (Vector2) {GetScreenWidth() - 8 * config.font.size,  config.font.size + 2};
-		DrawTextEx(config.font.style, scoreText, scorePos, config.font.size, 2, config.font.col);
-		DrawTextEx(config.font.style, highScoreText, highScorePos, config.font.size, 2, config.font.col);
-		DrawTextEx(config.font.style, timeText, timePos, config.font.size, 2, config.font.col);
-		for (auto e : m_entities.getEntities())
-		{
-			if (e->cTransform)
-			{
-				if (!m_paused)
-				{
-					float posUpdateX = e->cTransform->velocity.x * (1.0f / (float)(config.window.fps));
-					float posUpdateY = e->cTransform->velocity.y * (1.0f / (float)(config.window.fps));
-					if (e->cDash)
-					{
-						if (e->cDash->active)
-						{
-							posUpdateX *= e->cDash->speedMod;
-							posUpdateY *= e->cDash->speedMod;
-						}
-					}
-					e->cTransform->pos.x += posUpdateX;
-					e->cTransform->pos.y += posUpdateY;
-				}
-				if (e->cShape)
-				{
-					DrawPoly(e->cTransform->pos, e->cShape->sides, e->cShape->radius, e->cTransform->rotation, e->cShape->colour);
-					for (int i = 0; i < e->cShape->outlineW; i++)
-					{
-						DrawPolyLines(e->cTransform->pos, e->cShape->sides, e->cShape->radius + i, e->cTransform->rotation, e->cShape->outlineC);
-					}
-					// full rotation every 4 seconds
-					e->cTransform->rotation += 90.0 / (float) config.window.fps;
-				}
-				if (e->cLabel)
-				{
-					DrawTextEx(config.font.style, e->cLabel->text, e->cTransform->pos, e->cLabel->size, 2, e->cLabel->colour);
-				}
-			}
+#if defined(SW_PROFILE)
+		if ( m_showProfile )
+		{
+			m_profiler.draw(config.font.style, config.font.size * 0.75f, (Vector2) {8, config.font.size * 3 + 2}, config.font.col);
 		}
-		if ( m_paused )
+#endif
+		if ( frame.paused )
 		{
 			m_overlay.update();
 			m_overlay.render();
@@ -444,13 +947,14 @@ void Game::sRender()
 
 void Game::spawnPlayer()
 {
-	Vector2 center = (Vector2) {static_cast<float>(GetScreenWidth() / 2), static_cast<float>(GetScreenHeight() / 2)};
+	Vector2 center = (Vector2) {static_cast<float>(config.window.width / 2), static_cast<float>(config.window.height / 2)};
 	// reset game
 	const char* labelText = "";
 	auto cleanup = m_entities.getEntities();
 	if (!cleanup.empty())
 	{
-		labelText = m_labels[GetRandomValue(1, m_labels.size() - 1)];
+		labelText = m_labels[m_labelRng.range(1, m_labels.size() - 1)];
+		m_deaths++;
 		for (auto e : cleanup)
 		{
 			m_entities.removeEntity(e);
@@ -461,22 +965,42 @@ void Game::spawnPlayer()
 		m_highScore = m_score;
 		labelText = m_labels[0];
 	}
+	m_lastScore = m_score;
 	m_score = 0;
 	m_currentFrame = 0;
 	// spawn message
 	auto label = m_entities.addEntity("Label");
 	label->cLabel = std::make_shared<CLabel>(labelText, config.font.size * 4, config.font.col);
-	Vector2 labelBounds = MeasureTextEx(config.font.style, label->cLabel->text,  config.font.size * 2, 2);
+	Vector2 labelBounds = (m_headless) ? (Vector2) {0, 0} : MeasureTextEx(config.font.style, label->cLabel->text,  config.font.size * 2, 2);
 	label->cTransform = std::make_shared<CTransform>((Vector2) {(center.x - labelBounds.x), (center.y - labelBounds.y)});
 	label->cDuration = std::make_shared<CDuration>(3 * config.window.fps / config.enemy.spawn, m_currentFrame);
 	// create the player
-	m_player = m_entities.addEntity("Player");
-	m_player->cCollision = std::make_shared<CCollision>(config.player.c_radius);
-	m_player->cInput = std::make_shared<CInput>();
-	m_player->cShape = std::make_shared<CShape>(config.player.sides, config.player.radius, config.player.fill, config.player.o_col, config.player.o_thick);
-	m_player->cTransform = std::make_shared<CTransform>((Vector2) {(center.x - m_player->cShape->radius / 2), (center.y - m_player->cShape->radius / 2)});
+	float radius = config.player.radius;
+	Vector2 start = (Vector2) {(center.x - radius / 2), (center.y - radius / 2)};
+	if ( m_twoPlayer )
+	{
+		// side by side, a few player widths apart
+		m_player = makePlayer((Vector2) {start.x - radius * 3, start.y}, config.player.fill);
+		m_player2 = makePlayer((Vector2) {start.x + radius * 3, start.y}, PLAYER2);
+	}
+	else
+	{
+		m_player = makePlayer(start, config.player.fill);
+		m_player2.reset();
+	}
+}
+
+std::shared_ptr<Entity> Game::makePlayer(const Vector2 pos, const Color fill)
+{
+	auto player = m_entities.addEntity("Player");
+	player->cCollision = std::make_shared<CCollision>(config.player.c_radius);
+	player->cInput = std::make_shared<CInput>();
+	player->cShape = std::make_shared<CShape>(config.player.sides, config.player.radius, fill, config.player.o_col, config.player.o_thick);
+	player->cTransform = std::make_shared<CTransform>(pos);
 	// TODO: settings in config??
-	m_player->cDash = std::make_shared<CDash>(config.window.fps / 4, 0, config.window.fps, 2.0, false);
+	player->cDash = std::make_shared<CDash>(config.window.fps / 4, 0, config.window.fps, 2.0, false);
+	
+	return player;
 }
 
 void Game::spawnEnemy()
@@ -485,7 +1009,9 @@ void Game::spawnEnemy()
 	float diameter = config.enemy.radius * 2;
 	int colourDiff = 0;
 	// ensure colour of enemy differs from background or player
-	Color fill = (Color) {static_cast<unsigned char>(GetRandomValue(0, 255)), static_cast<unsigned char>(GetRandomValue(0, 255)), static_cast<unsigned char>(GetRandomValue(0, 255)), 255};
+	int rgb[3];
+	m_spawnRng.range(rgb, 3, 0, 255);
+	Color fill = (Color) {static_cast<unsigned char>(rgb[0]), static_cast<unsigned char>(rgb[1]), static_cast<unsigned char>(rgb[2]), 255};
 	colourDiff += abs(fill.r - m_player->cShape->colour.r);
 	colourDiff += abs(fill.g - m_player->cShape->colour.g);
 	colourDiff += abs(fill.b - m_player->cShape->colour.b);
@@ -567,22 +1093,20 @@ void Game::spawnEnemy()
 			}
 		}
 	}
-	float posX = GetRandomValue(diameter, (GetScreenWidth() - diameter));
-	float posY = GetRandomValue(diameter, (GetScreenHeight() - diameter));
+	float posX = m_spawnRng.range(diameter, (config.window.width - diameter));
+	float posY = m_spawnRng.range(diameter, (config.window.height - diameter));
 	Vector2 pos = (Vector2) {posX, posY};
 	int playerLeft = m_player->cTransform->pos.x - m_player->cShape->radius * 2;
 	int playerRight = m_player->cTransform->pos.x + m_player->cShape->radius * 2;
 	int playerTop = m_player->cTransform->pos.y - m_player->cShape->radius * 2;
 	int playerBot = m_player->cTransform->pos.y + m_player->cShape->radius * 2;
-	float randNum1 = static_cast <float> (rand());
-	float randNum2 = static_cast <float> (rand());
-	float divisor = static_cast <float> (RAND_MAX/ (config.enemy.speed * 2));
-	Vector2 vel = (Vector2){randNum1 / divisor - config.enemy.speed, randNum2 / divisor - config.enemy.speed};
-	//Vector2 vel = (Vector2) {static_cast <float> (rand()) / (static_cast <float> (RAND_MAX/config.enemy.speed)), static_cast <float> (rand()) / (static_cast <float> (RAND_MAX/config.enemy.speed))};
+	float randVel[2];
+	m_spawnRng.uniform(randVel, 2, -config.enemy.speed, config.enemy.speed);
+	Vector2 vel = (Vector2){randVel[0], randVel[1]};
 	// ensure the enemy doesn't spawn too close to the player
 	if ((pos.x - playerLeft) <= (playerRight - playerLeft))
 	{
-		if (m_player->cTransform->pos.x < GetScreenWidth() / 2)
+		if (m_player->cTransform->pos.x < config.window.width / 2)
 		{
 			pos.x += m_player->cShape->radius * 2;
 			if (vel.x < 0)
@@ -601,7 +1125,7 @@ void Game::spawnEnemy()
 	}
 	if ((pos.y - playerTop) <= (playerBot - playerTop))
 	{
-		if (m_player->cTransform->pos.y < GetScreenHeight() / 2)
+		if (m_player->cTransform->pos.y < config.window.height / 2)
 		{
 			pos.y += m_player->cShape->radius * 2;
 			if (vel.y < 0)
@@ -619,7 +1143,7 @@ void Game::spawnEnemy()
 		}
 	}
 	enemy->cTransform = std::make_shared<CTransform>(pos, vel);
-	enemy->cShape = std::make_shared<CShape>(GetRandomValue(3, 8), config.enemy.radius, fill, config.enemy.o_col, config.enemy.o_thick);
+	enemy->cShape = std::make_shared<CShape>(m_spawnRng.range(3, 8), config.enemy.radius, fill, config.enemy.o_col, config.enemy.o_thick);
 	enemy->cCollision =  std::make_shared<CCollision>(config.enemy.c_radius);
 	enemy->cScore = std::make_shared<CScore>(100 * enemy->cShape->sides);
 }
@@ -644,11 +1168,11 @@ void Game::spawnDebris(std::shared_ptr<Entity> enemy)
 	m_entities.removeEntity(enemy);
 }
 
-void Game::spawnBullet(const Vector2 mousePos)
+void Game::spawnBullet(const Entity& player, const Vector2 mousePos)
 {
 	// TODO: try the fast inverse square root algorithm
 	auto b = m_entities.addEntity("Bullet");
-	Vector2 origin = m_player->cTransform->pos;
+	Vector2 origin = player.cTransform->pos;
 	Vector2 direction = (Vector2) {(mousePos.x - origin.x), (mousePos.y - origin.y)};
 	
 	float magSquare = direction.x * direction.x + direction.y * direction.y;
@@ -661,7 +1185,7 @@ void Game::spawnBullet(const Vector2 mousePos)
 	b->cDuration = std::make_shared<CDuration>(config.bullet.duration, m_currentFrame);
 }
 
-void Game::spawnSpecial()
+void Game::spawnSpecial(const Entity& player)
 {
 	// TODO: bomb setings in config file?
 	int lastCreated = -1 * config.window.fps;
@@ -675,42 +1199,77 @@ void Game::spawnSpecial()
 	if (m_currentFrame > lastCreated + config.window.fps / 2)
 	{
 		auto b = m_entities.addEntity("Bomb");
-		b->cTransform = std::make_shared<CTransform>(m_player->cTransform->pos);
+		b->cTransform = std::make_shared<CTransform>(player.cTransform->pos);
 		b->cShape = std::make_shared<CShape>(4, config.bullet.radius, config.bullet.col, config.bullet.o_col, config.bullet.o_thick);
 		b->cDuration =  std::make_shared<CDuration>(config.bullet.duration, m_currentFrame);
 	}
 }
 
-void Game::sCollision()
+void Game::playerBounds(Entity& player)
 {
-	// Player
 	// horizontal window bounds
-	if (m_player->cTransform->pos.x - m_player->cCollision->radius <= 0)
+	if (player.cTransform->pos.x - player.cCollision->radius <= 0)
 	{
-		m_player->cTransform->velocity.x = config.player.speed;
+		player.cTransform->velocity.x = config.player.speed;
 	}
-	else if (m_player->cTransform->pos.x + m_player->cCollision->radius > GetScreenWidth())
+	else if (player.cTransform->pos.x + player.cCollision->radius > config.window.width)
 	{
-		m_player->cTransform->velocity.x = -1 * config.player.speed;
+		player.cTransform->velocity.x = -1 * config.player.speed;
 	}
 	// vertical window bounds
-	if (m_player->cTransform->pos.y - m_player->cCollision->radius <= 0)
+	if (player.cTransform->pos.y - player.cCollision->radius <= 0)
+	{
+		player.cTransform->velocity.y = config.player.speed;
+	}
+	else if (player.cTransform->pos.y + player.cCollision->radius > config.window.height)
+	{
+		player.cTransform->velocity.y = -1 * config.player.speed;
+	}
+}
+
+// whichever player a circle overlaps, the first one if it's both
+std::shared_ptr<Entity> Game::hitPlayer(const Vector2 pos, float radius)
+{
+	if ( m_scenario )
+	{
+		// a respawn would clear the world the scenario built
+		return nullptr;
+	}
+	m_collisionPairs++;
+	if (CheckCollisionCircles(m_player->cTransform->pos, m_player->cCollision->radius, pos, radius))
 	{
-		m_player->cTransform->velocity.y = config.player.speed;
+		return m_player;
 	}
-	else if (m_player->cTransform->pos.y + m_player->cCollision->radius > GetScreenHeight())
+	m_collisionPairs += (m_player2) ? 1 : 0;
+	if (m_player2 && CheckCollisionCircles(m_player2->cTransform->pos, m_player2->cCollision->radius, pos, radius))
+	{
+		return m_player2;
+	}
+	
+	return nullptr;
+}
+
+void Game::sCollision()
+{
+	PROFILE_SCOPE(PROF_COLLISION);
+	// Player
+	playerBounds(*m_player);
+	if ( m_player2 )
 	{
-		m_player->cTransform->velocity.y = -1 * config.player.speed;
+		playerBounds(*m_player2);
 	}
+	// counted as they're tested, a respawn stops the pass early
+	m_collisionPairs = 0;
 	// Enemies
 	for (auto enemy : m_entities.getEntities("Enemy"))
 	{
 		if (enemy->cTransform && enemy->cCollision)
 		{
 			// collision with player
-			if (CheckCollisionCircles(m_player->cTransform->pos, m_player->cCollision->radius, enemy->cTransform->pos, enemy->cCollision->radius))
+			auto player = hitPlayer(enemy->cTransform->pos, enemy->cCollision->radius);
+			if (player)
 			{
-				if (m_player->cDash->active)
+				if (player->cDash->active)
 				{
 					spawnDebris(enemy);
 				}
@@ -721,12 +1280,12 @@ void Game::sCollision()
 				}
 			}
 			// horizontal window bounds
-			if (enemy->cTransform->pos.x - enemy->cCollision->radius <= 0 || enemy->cTransform->pos.x + enemy->cCollision->radius > GetScreenWidth())
+			if (enemy->cTransform->pos.x - enemy->cCollision->radius <= 0 || enemy->cTransform->pos.x + enemy->cCollision->radius > config.window.width)
 			{
 				enemy->cTransform->velocity.x *= -1;
 			}
 			// vertical window bounds
-			if (enemy->cTransform->pos.y - enemy->cCollision->radius <= 0 || enemy->cTransform->pos.y + enemy->cCollision->radius > GetScreenHeight())
+			if (enemy->cTransform->pos.y - enemy->cCollision->radius <= 0 || enemy->cTransform->pos.y + enemy->cCollision->radius > config.window.height)
 			{
 				enemy->cTransform->velocity.y *= -1;
 			}
@@ -734,6 +1293,7 @@ void Game::sCollision()
 		// bullets
 		for (auto bullet : m_entities.getEntities("Bullet"))
 		{
+			m_collisionPairs++;
 			if (CheckCollisionCircles(enemy->cTransform->pos, enemy->cCollision->radius, bullet->cTransform->pos, bullet->cCollision->radius))
 			{
 				m_entities.removeEntity(bullet);
@@ -743,13 +1303,14 @@ void Game::sCollision()
 		// special weapon
 		for (auto exp : m_entities.getEntities("Explosion"))
 		{
+			m_collisionPairs++;
 			if (CheckCollisionCircles(enemy->cTransform->pos, enemy->cCollision->radius, exp->cTransform->pos, exp->cCollision->radius))
 			{
 				m_entities.removeEntity(enemy);
 				m_score += enemy->cScore->val;
 				m_highScore = (m_score >= m_highScore) ? m_score : m_highScore;
 			}
-			if (CheckCollisionCircles(m_player->cTransform->pos, m_player->cCollision->radius, exp->cTransform->pos, exp->cCollision->radius))
+			if (hitPlayer(exp->cTransform->pos, exp->cCollision->radius))
 			{
 				spawnPlayer();
 				return;
@@ -762,9 +1323,10 @@ void Game::sCollision()
 		if (debris->cTransform && debris->cCollision)
 		{
 			// collision with player
-			if (CheckCollisionCircles(m_player->cTransform->pos, m_player->cCollision->radius, debris->cTransform->pos, debris->cCollision->radius))
+			auto player = hitPlayer(debris->cTransform->pos, debris->cCollision->radius);
+			if (player)
 			{
-				if (m_player->cDash->active)
+				if (player->cDash->active)
 				{
 					m_entities.removeEntity(debris);
 					m_score += debris->cScore->val;
@@ -780,6 +1342,7 @@ void Game::sCollision()
 		// bullets
 		for (auto bullet : m_entities.getEntities("Bullet"))
 		{
+			m_collisionPairs++;
 			if (CheckCollisionCircles(debris->cTransform->pos, debris->cCollision->radius, bullet->cTransform->pos, bullet->cCollision->radius))
 			{
 				m_entities.removeEntity(bullet);
@@ -790,6 +1353,7 @@ void Game::sCollision()
 		}
 		for (auto exp : m_entities.getEntities("Explosion"))
 		{
+			m_collisionPairs++;
 			if (CheckCollisionCircles(debris->cTransform->pos, debris->cCollision->radius, exp->cTransform->pos, exp->cCollision->radius))
 			{
 				m_entities.removeEntity(debris);
@@ -871,16 +1435,559 @@ bool Game::togglePause()
 	return m_paused;
 }
 
+RenderStats Game::renderStats() const
+{
+	return m_frames.front().stats;
+}
+
+void Game::draw(Renderer& renderer) const
+{
+	renderer.draw(m_frames.front());
+}
+
 void Game::setPause(bool p)
 {
-	m_overlay.getPage(0)->setActive(false);
 	back.currCol = config.window.col;
 	m_paused = p;
-	m_overlay.getPage(1)->setActive(m_paused);
+	if ( !m_headless )
+	{
+		m_overlay.getPage(0)->setActive(false);
+		m_overlay.getPage(1)->setActive(m_paused);
+	}
+}
+
+Game::~Game()
+{
+#if !defined(PLATFORM_WEB)
+	if ( m_simThread.joinable() )
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_simLock);
+			m_simQuit = true;
+		}
+		m_simSignal.notify_all();
+		m_simThread.join();
+	}
+#endif
 }
 
 void Game::cleanup()
 {
+	logFlush(); // anything still queued belongs before the summaries
+	if ( m_net )
+	{
+		std::cout << "played " << m_netTick << " ticks over the network, " << m_net->packets() << " packets in, rolled back " << m_rollbacks << " times (" << m_resimulated << " ticks resimulated, deepest " << m_deepestRollback << ")" << std::endl;
+	}
+	if ( m_spectators )
+	{
+		std::cout << "streamed " << m_spectators->frames() << " frames to " << m_spectators->viewers() << " spectators, " << m_spectators->bytes() << " bytes sent, " << m_spectators->skipped() << " frames skipped for slow viewers" << std::endl;
+	}
+	if ( m_metrics )
+	{
+		m_metrics->close();
+		std::cout << "served " << m_metrics->scrapes() << " metrics scrapes" << std::endl;
+	}
+	if ( m_watch )
+	{
+		size_t frames = (m_watch->frames()) ? m_watch->frames() : 1;
+		std::cout << "watched " << m_watch->frames() << " frames, " << m_watch->bytes() << " bytes (" << m_watch->bytes() / frames << " bytes/frame)" << std::endl;
+	}
+	FrameHistogram frames = m_frameTimes.histogram();
+	if ( frames.count() )
+	{
+		std::cout << std::fixed << std::setprecision(2) << "frame times over the last " << frames.count() << " frames: p50 " << frames.quantile(0.5) / 1e3 << " ms, p99 " << frames.quantile(0.99) / 1e3 << " ms, p99.9 " << frames.quantile(0.999) / 1e3 << " ms, max " << frames.max() / 1e3 << " ms" << std::defaultfloat << std::setprecision(6) << std::endl;
+	}
+	if ( m_frameTimes.budget() )
+	{
+		std::cout << m_frameTimes.hitches() << " frames over the " << m_frameTimes.budget() / 1e3 << " ms budget, " << m_frameTimes.captures() << " captured to " << m_hitchDir << std::endl;
+	}
+#if defined(SW_PROFILE)
+	m_profiler.report();
+	if ( m_trace && !m_traceFile.empty() )
+	{
+		m_profiler.setTrace(nullptr);
+		if ( m_trace->write(m_traceFile.c_str()) )
+		{
+			std::cout << "wrote " << m_trace->size() << " trace events to " << m_traceFile << std::endl;
+		}
+		else
+		{
+			std::cout << "could not write trace " << m_traceFile << std::endl;
+		}
+	}
+#endif
+	if ( m_recorder )
+	{
+		m_recorder->close();
+		std::cout << "recorded " << m_recorder->ticks() << " ticks" << std::endl;
+	}
+	if ( m_headless )
+	{
+		return;
+	}
 	UnloadFont(config.font.style); // we use smart pointers for everything else
 	UnloadTexture(*(m_logo.get()));
 }
+
+bool Game::headless() const
+{
+	return m_headless;
+}
+
+int Game::score() const
+{
+	return m_score;
+}
+
+int Game::currentFrame() const
+{
+	return m_currentFrame;
+}
+
+uint64_t Game::seed() const
+{
+	return m_seed;
+}
+
+void Game::setSpeed(int ticksPerFrame)
+{
+	m_speed = (ticksPerFrame > 1) ? ticksPerFrame : 1;
+}
+
+int Game::speed() const
+{
+	return m_speed;
+}
+
+size_t Game::ticks() const
+{
+	return m_ticks;
+}
+
+bool Game::record(const char* file)
+{
+	ReplayHeader header;
+	header.seed = m_seed;
+	header.fps = config.window.fps;
+	header.width = config.window.width;
+	header.height = config.window.height;
+	header.paused = m_paused;
+	m_recorder = std::make_unique< InputRecorder >();
+	if ( !m_recorder->open(file, header) )
+	{
+		std::cout << "could not open " << file << " for recording" << std::endl;
+		m_recorder.reset();
+		return false;
+	}
+	std::cout << "recording input to " << file << std::endl;
+	
+	return true;
+}
+
+bool Game::replay(const char* file)
+{
+	m_playback = std::make_unique< InputPlayback >();
+	if ( !m_playback->open(file) )
+	{
+		std::cout << "could not read replay " << file << std::endl;
+		m_playback.reset();
+		return false;
+	}
+	const ReplayHeader& header = m_playback->header();
+	if ( header.fps != config.window.fps || header.width != config.window.width || header.height != config.window.height )
+	{
+		std::cout << "warning: replay was recorded with a different window config and will not play back exactly" << std::endl;
+	}
+	std::cout << "replaying " << file << std::endl;
+	reset(header.seed);
+	setPause(header.paused);
+	m_replayDone = false;
+	
+	return true;
+}
+
+bool Game::host(uint16_t port)
+{
+	m_net = std::make_unique< NetSession >();
+	if ( !m_net->host(port, m_seed) )
+	{
+		std::cout << "could not listen on port " << port << std::endl;
+		m_net.reset();
+		return false;
+	}
+	std::cout << "hosting a two player game on port " << port << std::endl;
+	startNet();
+	
+	return true;
+}
+
+bool Game::join(const char* address, uint16_t port)
+{
+	m_net = std::make_unique< NetSession >();
+	if ( !m_net->join(address, port) )
+	{
+		std::cout << "could not join " << address << ":" << port << std::endl;
+		m_net.reset();
+		return false;
+	}
+	std::cout << "joined " << address << ":" << port << " with seed " << m_net->seed() << std::endl;
+	startNet();
+	
+	return true;
+}
+
+bool Game::spectate(uint16_t port)
+{
+	m_spectators = std::make_unique< SpectatorServer >();
+	if ( !m_spectators->listen(port) )
+	{
+		std::cout << "could not listen for spectators on port " << port << std::endl;
+		m_spectators.reset();
+		return false;
+	}
+	std::cout << "streaming to spectators on port " << port << std::endl;
+	
+	return true;
+}
+
+bool Game::watch(const char* address, uint16_t port)
+{
+	m_watch = std::make_unique< SpectatorClient >();
+	if ( !m_watch->connect(address, port) )
+	{
+		std::cout << "could not watch " << address << ":" << port << std::endl;
+		m_watch.reset();
+		return false;
+	}
+	std::cout << "watching " << address << ":" << port << std::endl;
+	m_replayDone = false;
+	
+	return true;
+}
+
+bool Game::trace(const char* file, int seconds)
+{
+#if defined(SW_PROFILE)
+	// a tick is about a dozen spans and a dozen counters, round up so the ring covers at least the time asked for
+	m_trace = std::make_unique< TraceBuffer >((size_t)seconds * config.window.fps * 32);
+	m_traceFile = file;
+	m_profiler.setTrace(m_trace.get());
+	std::cout << "tracing the last " << seconds << "s to " << file << std::endl;
+	
+	return true;
+#else
+	std::cout << "tracing needs a build with PROFILE=TRUE" << std::endl;
+	
+	return false;
+#endif
+}
+
+bool Game::metrics(uint16_t port)
+{
+	m_metrics = std::make_unique< MetricsServer >();
+	if ( !m_metrics->listen(port) )
+	{
+		std::cout << "could not serve metrics on port " << port << std::endl;
+		m_metrics.reset();
+		return false;
+	}
+	std::cout << "serving metrics on http://127.0.0.1:" << port << "/metrics" << std::endl;
+
+	return true;
+}
+
+// between frames, so the simulation thread is idle and the world can be read
+void Game::sMetrics()
+{
+	MetricsSnapshot& snapshot = m_published;
+	FrameHistogram frames = m_frameTimes.histogram();
+	snapshot.frameSeconds[0] = frames.quantile(0.5) / 1e6;
+	snapshot.frameSeconds[1] = frames.quantile(0.9) / 1e6;
+	snapshot.frameSeconds[2] = frames.quantile(0.99) / 1e6;
+	snapshot.frameSeconds[3] = frames.max() / 1e6;
+#if defined(SW_PROFILE)
+	snapshot.systems = true;
+	for (int s = 0; s < PROF_COUNT; s++)
+	{
+		snapshot.systemSeconds[s] = m_profiler.stats((ProfSystem)s).average / 1e6;
+	}
+#endif
+#if defined(SW_ALLOCS)
+	ProfStats frame = m_profiler.stats(PROF_FRAME);
+	snapshot.allocs = true;
+	snapshot.allocsPerFrame = frame.allocs;
+	snapshot.allocBytesPerFrame = frame.allocBytes;
+#endif
+	snapshot.tagCount = 0;
+	for (const char* tag : entityTags)
+	{
+		snapshot.tags[snapshot.tagCount] = tag;
+		snapshot.entities[snapshot.tagCount++] = m_entities.getEntities(tag).size();
+	}
+	snapshot.tags[snapshot.tagCount] = "Background";
+	snapshot.entities[snapshot.tagCount++] = back.entities.getEntities().size();
+	snapshot.spawned = m_entities.spawned();
+	snapshot.despawned = m_entities.despawned();
+	RenderStats shapes = renderStats();
+	snapshot.shapesDrawn = shapes.shapes;
+	snapshot.shapesCulled = shapes.culled;
+	snapshot.score = m_score;
+	snapshot.highScore = m_highScore;
+	snapshot.frame = m_currentFrame;
+	snapshot.ticks = m_ticks;
+	m_metrics->publish(snapshot);
+}
+
+bool Game::counters()
+{
+#if defined(SW_PROFILE)
+	if ( !perfCountersEnable() )
+	{
+		std::cout << "could not open hardware counters, they need Linux with perf_event_paranoid at 2 or less" << std::endl;
+		return false;
+	}
+	std::cout << "counting cycles, instructions, cache and branch misses per system" << std::endl;
+
+	return true;
+#else
+	std::cout << "hardware counters need a build with PROFILE=TRUE" << std::endl;
+
+	return false;
+#endif
+}
+
+bool Game::hitches(const char* dir, double budget, int seconds)
+{
+	std::error_code error;
+	std::filesystem::create_directories(dir, error);
+	if ( error )
+	{
+		std::cout << "could not make hitch directory " << dir << std::endl;
+		return false;
+	}
+	m_hitchDir = dir;
+	m_frameTimes.setBudget(budget * 1e6 / config.window.fps, (size_t)seconds * config.window.fps);
+#if defined(SW_PROFILE)
+	// spans for the black box even without --trace, only written when there's a hitch
+	if ( !m_trace )
+	{
+		m_trace = std::make_unique< TraceBuffer >((size_t)seconds * config.window.fps * 32);
+		m_profiler.setTrace(m_trace.get());
+	}
+#endif
+	std::cout << "capturing frames over " << m_frameTimes.budget() / 1e3 << " ms to " << dir << std::endl;
+
+	return true;
+}
+
+// called between frames, so the simulation thread is idle and the trace can be read
+void Game::captureHitch(uint64_t micros)
+{
+	std::string file = m_hitchDir + "/hitch-" + std::to_string(m_frameTimes.captures());
+	FrameHistogram frames = m_frameTimes.histogram();
+	nlohmann::json j_hitch;
+	j_hitch["frame_ms"] = micros / 1e3;
+	j_hitch["budget_ms"] = m_frameTimes.budget() / 1e3;
+	j_hitch["tick"] = m_ticks;
+	j_hitch["frame"] = m_currentFrame;
+	j_hitch["seed"] = m_seed;
+	j_hitch["score"] = m_score;
+	j_hitch["frame_times_ms"] = {
+		{"p50", frames.quantile(0.5) / 1e3},
+		{"p99", frames.quantile(0.99) / 1e3},
+		{"p99.9", frames.quantile(0.999) / 1e3},
+		{"max", frames.max() / 1e3},
+		{"frames", frames.count()}
+	};
+	for (const char* tag : entityTags)
+	{
+		j_hitch["entities"][tag] = m_entities.getEntities(tag).size();
+	}
+	j_hitch["entities"]["Background"] = back.entities.getEntities().size();
+	// buttons, mouse x and y for each tick, oldest first
+	j_hitch["inputs"] = nlohmann::json::array();
+	for (const InputFrame& input : m_frameTimes.inputs())
+	{
+		j_hitch["inputs"].push_back({input.buttons, input.mouseX, input.mouseY});
+	}
+	std::ofstream output(file + ".json", std::ios::trunc);
+	if ( !(output << j_hitch.dump(1, '\t') << std::endl) )
+	{
+		std::cout << "could not write hitch " << file << ".json" << std::endl;
+		return;
+	}
+#if defined(SW_PROFILE)
+	if ( !m_trace->write((file + ".trace.json").c_str()) )
+	{
+		std::cout << "could not write trace " << file << ".trace.json" << std::endl;
+	}
+#endif
+	SW_WARN("hitch: frame took %.1f ms, captured to %s", micros / 1e3, file.c_str());
+}
+
+void Game::loadScenario(const ScenarioConfig& scenario)
+{
+	std::cout << "loading scenario " << scenario.name << std::endl;
+	m_scenario = true;
+	m_spawner = scenario.spawner;
+	reset(scenario.seed);
+	m_paused = false;
+	m_menu = false;
+	for (int i = 0; i < scenario.enemies + scenario.bursts; i++)
+	{
+		spawnEnemy();
+	}
+	for (int i = 0; i < scenario.bombs; i++)
+	{
+		float posX = m_spawnRng.uniform(0, config.window.width);
+		float posY = m_spawnRng.uniform(0, config.window.height);
+		auto b = m_entities.addEntity("Bomb");
+		b->cTransform = std::make_shared<CTransform>((Vector2) {posX, posY});
+		b->cShape = std::make_shared<CShape>(4, config.bullet.radius, config.bullet.col, config.bullet.o_col, config.bullet.o_thick);
+		b->cDuration = std::make_shared<CDuration>(m_spawnRng.range(scenario.fuse[0], scenario.fuse[1]), m_currentFrame);
+	}
+	m_entities.update();
+	// the last few enemies are the ones that burst, spawnDebris needs them in the manager first
+	auto& enemies = m_entities.getEntities("Enemy");
+	for (size_t i = enemies.size() - scenario.bursts; i < enemies.size(); i++)
+	{
+		enemies[i]->cShape->sides = scenario.burstSides;
+		enemies[i]->cScore->val = 100 * scenario.burstSides;
+		spawnDebris(enemies[i]);
+	}
+	m_entities.update();
+	std::cout << m_entities.getEntities("Enemy").size() << " enemies, " << m_entities.getEntities("Bomb").size() << " bombs, " << m_entities.getEntities("Debris").size() << " debris" << std::endl;
+}
+
+size_t Game::entityCount()
+{
+	return m_entities.getEntities().size();
+}
+
+bool Game::replayFinished() const
+{
+	return m_replayDone;
+}
+
+void Game::captureState(WorldState& state)
+{
+	state.seed = m_seed;
+	state.score = m_score;
+	state.highScore = m_highScore;
+	state.currentFrame = m_currentFrame;
+	state.paused = m_paused;
+	state.player = m_player->id();
+	state.player2 = (m_player2) ? m_player2->id() + 1 : 0;
+	state.spawnRng = m_spawnRng.getState();
+	state.labelRng = m_labelRng.getState();
+	state.tags.clear();
+	captureEntities(m_entities, state.world, state.tags, m_labels);
+	state.backCol = back.currCol;
+	state.backFrames = back.frames;
+	state.backIndex = back.index;
+	state.backRng = back.rng.getState();
+	captureEntities(back.entities, state.back, state.tags, m_labels);
+}
+
+void Game::restoreState(const WorldState& state)
+{
+	if ( m_paused != (bool)state.paused )
+	{
+		setPause(state.paused);
+	}
+	m_seed = state.seed;
+	m_score = state.score;
+	m_highScore = state.highScore;
+	m_currentFrame = state.currentFrame;
+	m_spawnRng.setState(state.spawnRng);
+	m_labelRng.setState(state.labelRng);
+	restoreEntities(m_entities, state.world, state.tags, m_labels);
+	// the players are usually pending right after a respawn, so look there first
+	m_player.reset();
+	m_player2.reset();
+	for (auto e : m_entities.getPending())
+	{
+		if ( e->id() == state.player )
+		{
+			m_player = e;
+		}
+		if ( e->id() + 1 == state.player2 )
+		{
+			m_player2 = e;
+		}
+	}
+	for (auto e : m_entities.getEntities("Player"))
+	{
+		if ( e->id() == state.player )
+		{
+			m_player = e;
+		}
+		if ( e->id() + 1 == state.player2 )
+		{
+			m_player2 = e;
+		}
+	}
+	// a state from another build or a hand edited file. The rest of the world is kept and the missing player starts
+	// again in the middle, rather than the systems following a pointer into the world that was just replaced
+	Vector2 start = (Vector2) {(config.window.width - config.player.radius) / 2.0f, (config.window.height - config.player.radius) / 2.0f};
+	if ( !m_player )
+	{
+		SW_WARN("save state has no player %u, spawning a new one", state.player);
+		m_player = makePlayer(start, config.player.fill);
+	}
+	if ( state.player2 && !m_player2 )
+	{
+		SW_WARN("save state has no second player %u, spawning a new one", state.player2 - 1);
+		m_player2 = makePlayer(start, PLAYER2);
+	}
+	m_twoPlayer = (bool)m_player2;
+	back.currCol = state.backCol;
+	back.frames = state.backFrames;
+	back.index = state.backIndex;
+	back.rng.setState(state.backRng);
+	restoreEntities(back.entities, state.back, state.tags, m_labels);
+}
+
+bool Game::saveState(const char* file)
+{
+	WorldState state;
+	ByteWriter out;
+	captureState(state);
+	encodeWorld(state, out);
+	std::ofstream output(file, std::ios::binary | std::ios::trunc);
+	output.write((const char*)out.data().data(), out.size());
+	if ( !output )
+	{
+		std::cout << "could not write save state " << file << std::endl;
+		return false;
+	}
+	std::cout << "saved " << state.world.entities.size() << " entities to " << file << " (" << out.size() << " bytes)" << std::endl;
+	
+	return true;
+}
+
+bool Game::loadState(const char* file)
+{
+	// one read of the whole file, a byte at a time through a stream iterator took longer than decoding it
+	std::ifstream input(file, std::ios::binary | std::ios::ate);
+	std::streamoff size = input.tellg();
+	std::vector< uint8_t > data((size > 0) ? size : 0);
+	input.seekg(0);
+	input.read((char*)data.data(), data.size());
+	ByteReader in(data);
+	WorldState state;
+	if ( !input || !decodeWorld(in, state) )
+	{
+		std::cout << "could not read save state " << file << std::endl;
+		return false;
+	}
+	restoreState(state);
+	std::cout << "loaded " << state.world.entities.size() << " entities from " << file << std::endl;
+	
+	return true;
+}
+
+const GameConfig& Game::getConfig() const
+{
+	return config;
+}
@@ -1,6 +1,18 @@
 #pragma once
 
 #include "EntityManager.h"
+#include "Snapshot.h"
+#include "RaylibRenderer.h"
+#include "Random.h"
+#include "Replay.h"
+#include "SaveState.h"
+#include "StateDelta.h"
+#include "Net.h"
+#include "Spectator.h"
+#include "Profiler.h"
+#include "Hitch.h"
+#include "Metrics.h"
+#include "Log.h"
 #include "include/NoGUI/src/GUI.h"
 #include "include/json/json.hpp"
 #include <math.h>
@@ -8,8 +20,15 @@
 #include <time.h>
 #include <fstream>
 #include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <filesystem>
 #if defined(PLATFORM_WEB)
 	#include <emscripten/emscripten.h>
+#else
+	#include <thread>
+	#include <mutex>
+	#include <condition_variable>
 #endif
 
 // colours
@@ -17,6 +36,7 @@ const Color INVISIBLE = (Color){0, 0, 0, 1};
 const Color OFFGRAY = (Color){120, 120, 120, 255};
 const Color BACKGREEN = (Color){15, 20, 10, 255};
 const Color BACKBLUE = (Color){70, 135, 170, 255};
+const Color PLAYER2 = (Color){0, 117, 44, 255}; // second player's fill
 
 // default configuration
 struct WindowConfig 
@@ -71,6 +91,7 @@ struct BulletConfig
 
 struct GameConfig
 {
+	uint64_t seed = 0; // RNG seed, 0 picks one from the clock
 	WindowConfig window;
 	FontConfig font;
 	PlayerConfig player;
@@ -85,6 +106,30 @@ void parse_player(PlayerConfig& config, const nlohmann::json& json);
 void parse_enemy(EnemyConfig& config, const nlohmann::json& json);
 void parse_bullet(BulletConfig& config, const nlohmann::json& json);
 
+// a synthetic world to stress the systems with, see scenarios/. Every count is multiplied by the runner's scale
+struct ScenarioConfig
+{
+	std::string name;
+	long ticks = 600; // run for this long unless --ticks says otherwise
+	uint64_t seed = 1;
+	int enemies = 0; // bouncing around the window at the usual enemy speeds
+	int bombs = 0; // dropped among the enemies, each blowing up into an explosion after its fuse
+	int fuse[2] = {30, 120}; // frames, each bomb's is picked from this range so the explosions are staggered
+	int bursts = 0; // enemies blown apart into debris before the first tick
+	int burstSides = 8; // so sides pieces of debris each
+	bool spawner = false; // keep the gameplay spawn ramp running on top
+};
+
+bool parse_scenario(ScenarioConfig& scenario, const char* file, float scale = 1);
+
+// one independent RNG stream per system so adding draws to one system doesn't shift the others
+enum RngStream
+{
+	RNG_SPAWN = 1,
+	RNG_LABEL,
+	RNG_BACKGROUND
+};
+
 // custom configuration
 const std::map< std::string, Vector2 > map169 = {
 	{"3840 x 2160 UHD", (Vector2){3840, 2160}},
@@ -110,9 +155,13 @@ const std::map< std::string, int > mapFPS = {
 class Background
 {
 friend class Game;
+friend class Benchmarks;
+friend class GameTests;
 private:
 	EntityManager entities;
 	EnemyConfig& enemyConfig;
+	WindowConfig& windowConfig; // the game's, a resize is picked up by the next spawn
+	Rng rng;
 	std::vector< Color > colours;
 	size_t tframes = 200;
 	size_t hframes = 60;
@@ -123,85 +172,230 @@ public:
 	void spawner();
 	void spawnEntity();
 	void step();
-	void draw();
+	void move(float dt);
+	void snapshot(RenderSnapshot& frame);
 	int addCol(const Color& col);
 	int removeCol(int index);
 	void setCol(const std::vector< Color >& col);
-	Background(EnemyConfig& config, const Color& init)
-		: enemyConfig(config), currCol(init) {addCol(init);}
-	Background(EnemyConfig& config, const std::vector< Color >& init)
-		: enemyConfig(config), currCol(init.front()), colours(init) {}
-	Background(EnemyConfig& config)
-		: enemyConfig(config) {}
+	Background(EnemyConfig& config, WindowConfig& window, const Color& init)
+		: enemyConfig(config), windowConfig(window), currCol(init) {addCol(init);}
+	Background(EnemyConfig& config, WindowConfig& window, const std::vector< Color >& init)
+		: enemyConfig(config), windowConfig(window), currCol(init.front()), colours(init) {}
+	Background(EnemyConfig& config, WindowConfig& window)
+		: enemyConfig(config), windowConfig(window) {}
 };
 
 class Game
 {
+friend class VecEnv;
+friend class ObservationEncoder;
+friend class Benchmarks;
+friend class GameTests;
 	// entities
 	EntityManager m_entities;
 	NoGUI::GUIManager m_overlay;
 	std::shared_ptr< Texture2D > m_logo;
 	std::shared_ptr< Entity > m_player; 
+	std::shared_ptr< Entity > m_player2; // only in two player games
 	// components
 	int m_score = 0;
 	int m_highScore = 0;
 	bool m_paused = true;
+	bool m_menu = true; // main menu is showing, cached by sInput so the simulation never touches the GUI
 	int m_currentFrame = 0;
+	int m_deaths = 0; // times the player has respawned since the last reset
+	int m_lastScore = 0; // final score of the run that ended with the last respawn
 	std::vector<const char*> m_labels{"NEW HIGHSCORE!", "TRY AGAIN!!", "MY GRANDMA COULD DO BETTER", "YOU CAN DO IT!", "GIT GUD LOL", "NICE TRY!", "SO CLOSE!", "YOU GOT THIS"};
 	Background back;
+	// RNG
+	uint64_t m_seed = 0;
+	Rng m_spawnRng;
+	Rng m_labelRng;
 	// configuration
 	GameConfig config;
+	bool m_headless = false; // no window, GL context, font or textures
+	int m_speed = 1; // ticks simulated per presented frame
+	size_t m_ticks = 0; // ticks simulated since start up
+	// two player games, the second player's input comes over the network
+	bool m_twoPlayer = false;
+	std::unique_ptr< NetSession > m_net;
+	StateHistory m_netHistory; // one state per tick we might still have to rewind to
+	WorldState m_netState;
+	size_t m_netTick = 0;
+	size_t m_rollbacks = 0;
+	size_t m_resimulated = 0;
+	size_t m_deepestRollback = 0;
+	void startNet();
+	bool netStep(InputFrame local);
+	void netSimulate(size_t tick);
+	// spectators
+	std::unique_ptr< SpectatorServer > m_spectators;
+	SpecFrame m_spectated; // reused every tick
+	std::unique_ptr< SpectatorClient > m_watch;
+	void sSpectate();
+	void watchStep();
+	// input log
+	std::unique_ptr< InputRecorder > m_recorder;
+	std::unique_ptr< InputPlayback > m_playback;
+	bool m_replayDone = false;
+	// stress scenarios, players can't die so the world isn't wiped and sEnemySpawner only runs if asked for
+	bool m_scenario = false;
+	bool m_spawner = true;
+	// frame times, and the black box that captures frames over budget
+	HitchDetector m_frameTimes;
+	std::chrono::steady_clock::time_point m_lastFrame;
+	std::string m_hitchDir;
+	void captureHitch(uint64_t micros);
+	// Prometheus endpoint, published to a few times a second
+	std::unique_ptr< MetricsServer > m_metrics;
+	MetricsSnapshot m_published;
+	std::chrono::steady_clock::time_point m_lastPublish;
+	void sMetrics();
+	// rendering
+	size_t m_collisionPairs = 0; // tested by the last sCollision
+#if defined(SW_PROFILE)
+	Profiler m_profiler;
+	bool m_showProfile = false; // F3
+	std::unique_ptr< TraceBuffer > m_trace;
+	std::string m_traceFile;
+	size_t m_tracedSpawns = 0;
+	size_t m_tracedDespawns = 0;
+	void sTraceCounters();
+#endif
+	SnapshotBuffer m_frames;
+	RaylibRenderer m_renderer;
+#if !defined(PLATFORM_WEB)
+	// simulation thread, steps the next tick while the main thread draws the last one
+	std::thread m_simThread;
+	std::mutex m_simLock;
+	std::condition_variable m_simSignal;
+	bool m_simPending = false;
+	bool m_simQuit = false;
+	void simLoop();
+#endif
+	void beginStep();
+	void endStep();
+	void step();
+	void simulate();
+	void fastForward(InputFrame input);
+	bool nextInput(InputFrame& input, bool repeat = false);
+	void reset(uint64_t seed);
+	InputFrame pollInput();
 	// systems
 	void sDuration();
 	void sMove();
-	void sInput();
+	void sTransform();
+	void sSnapshot();
+	void sInput(const InputFrame& input);
+	void sInput2(const InputFrame& input);
+	void applyInput(std::shared_ptr<Entity> player, const InputFrame& input);
+	void movePlayer(Entity& player);
+	void playerBounds(Entity& player);
+	std::shared_ptr<Entity> hitPlayer(const Vector2 pos, float radius);
 	void sRender();
 	void sEnemySpawner();
 	void spawnPlayer();
+	std::shared_ptr<Entity> makePlayer(const Vector2 pos, const Color fill);
 	void spawnEnemy();
 	void spawnDebris(std::shared_ptr<Entity> enemy);
-	void spawnBullet(const Vector2 mousePos);
-	void spawnSpecial();
+	void spawnBullet(const Entity& player, const Vector2 mousePos);
+	void spawnSpecial(const Entity& player);
 	void sCollision();
 	void load_menu();
 	void load_settings();
 public:
-	Game(const char* confile)
-		: back(config.enemy)
+	Game(const char* confile, bool headless = false, uint64_t seed = 0)
+		: back(config.enemy, config.window), m_headless(headless)
 		{
 			bool readConf = parse_config(config, confile);
 			if ( !(readConf) )
 			{
 				std::cout << "could not read config file" << std::endl;
 			}
-			std::cout << "initalizing window" << std::endl;
-			InitWindow(config.window.width, config.window.height, "Shape Wars");
-#if defined(PLATFORM_DESKTOP)
-			SetTargetFPS(config.window.fps);
-			if (config.window.full)
+			if ( m_headless )
 			{
-				std::cout << "setting Fullscreen" << std::endl;
-				ToggleFullscreen();
+				// no window, font or textures. The game starts straight away and nothing is drawn unless asked for
+				std::cout << "running headless" << std::endl;
+				m_paused = false;
+				m_menu = false;
+				back.currCol = config.window.col; // what --frames draws behind everything
 			}
+			else
+			{
+				std::cout << "initalizing window" << std::endl;
+				InitWindow(config.window.width, config.window.height, "Shape Wars");
+#if defined(PLATFORM_DESKTOP)
+				SetTargetFPS(config.window.fps);
+				if (config.window.full)
+				{
+					std::cout << "setting Fullscreen" << std::endl;
+					ToggleFullscreen();
+				}
 #endif
-			std::cout << "loading font" << std::endl;
-			config.font.style = (readConf) ? LoadFont(config.font.file.c_str()) : GetFontDefault();
-			std::cout << "loading menu" << std::endl;
-			m_overlay = NoGUI::GUIManager();
-			back.addCol(config.window.col);
-			back.currCol = config.window.col;
-			back.addCol(BACKBLUE);
-			load_menu();
-			load_settings();
-			m_overlay.getPage(1)->setActive(false);
+				std::cout << "loading font" << std::endl;
+				config.font.style = (readConf) ? LoadFont(config.font.file.c_str()) : GetFontDefault();
+				m_renderer.setFont(config.font.style, config.font.size, config.font.col);
+				std::cout << "loading menu" << std::endl;
+				m_overlay = NoGUI::GUIManager();
+				back.addCol(config.window.col);
+				back.currCol = config.window.col;
+				back.addCol(BACKBLUE);
+				load_menu();
+				load_settings();
+				m_overlay.getPage(1)->setActive(false);
+			}
+			// a seed from the command line wins over the config file
 			std::cout << "loading entities" << std::endl;
-			m_entities = EntityManager();
-			spawnPlayer();
-			std::cout << "seeding RNG" << std::endl;
-			srand( (unsigned)time(NULL) );
+			reset((seed) ? seed : (config.seed) ? config.seed : (uint64_t)time(NULL));
+#if !defined(PLATFORM_WEB)
+#if defined(SW_PROFILE)
+			nameTraceThread("main");
+#endif
+			if ( !m_headless )
+			{
+				std::cout << "starting simulation thread" << std::endl;
+				m_simThread = std::thread(&Game::simLoop, this);
+			}
+#endif
 		}
+	~Game();
 	void run();
 	void cleanup();
 	void setPause(bool p=true);
 	bool togglePause();
+	RenderStats renderStats() const;
+	void draw(Renderer& renderer) const;
+	bool headless() const;
+	int score() const;
+	int currentFrame() const;
+	uint64_t seed() const;
+	void setSpeed(int ticksPerFrame);
+	int speed() const;
+	size_t ticks() const;
+	bool record(const char* file);
+	bool replay(const char* file);
+	bool replayFinished() const; // or the watched stream
+	// two player games over UDP, call before the first run()
+	bool host(uint16_t port);
+	bool join(const char* address, uint16_t port);
+	// stream the game to viewers over TCP, or be one. A watching game simulates nothing and ends with the stream
+	bool spectate(uint16_t port);
+	bool watch(const char* address, uint16_t port);
+	// keep the last few seconds of system timings and counters, written as a Chrome trace on exit. Needs PROFILE=TRUE
+	bool trace(const char* file, int seconds = 10);
+	// Prometheus text format at http://127.0.0.1:port/metrics, served from its own thread
+	bool metrics(uint16_t port);
+	// cycles, instructions, cache and branch misses per system next to the timings, Linux with PROFILE=TRUE only
+	bool counters();
+	// frames over budget times the fps period dump the last few seconds of input, entity counts and (with PROFILE=TRUE) trace to dir
+	bool hitches(const char* dir, double budget = 1.5, int seconds = 10);
+	// replace the world with a stress scenario's
+	void loadScenario(const ScenarioConfig& scenario);
+	size_t entityCount();
+	// save states
+	void captureState(WorldState& state);
+	void restoreState(const WorldState& state);
+	bool saveState(const char* file);
+	bool loadState(const char* file);
+	const GameConfig& getConfig() const;
 };
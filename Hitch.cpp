@@ -0,0 +1,175 @@
+#include "Hitch.h"
+
+namespace
+{
+	const size_t MAX_CAPTURES = 16; // per run
+
+	int highestBit(uint64_t v)
+	{
+		int bit = 0;
+		while ( v >>= 1 )
+		{
+			bit++;
+		}
+
+		return bit;
+	}
+
+	// values below 64 get a bucket each, above that the top 6 bits pick the bucket
+	size_t bucketOf(uint64_t micros)
+	{
+		int shift = highestBit(micros) - 5;
+		shift = (shift < 0) ? 0 : (shift > HISTOGRAM_SHIFTS - 1) ? HISTOGRAM_SHIFTS - 1 : shift;
+		uint64_t base = micros >> shift;
+		base = (base < 2 * HISTOGRAM_SUB_BUCKETS) ? base : 2 * HISTOGRAM_SUB_BUCKETS - 1;
+
+		return shift * HISTOGRAM_SUB_BUCKETS + base;
+	}
+
+	uint64_t bucketTop(size_t bucket)
+	{
+		size_t shift = (bucket < 2 * HISTOGRAM_SUB_BUCKETS) ? 0 : bucket / HISTOGRAM_SUB_BUCKETS - 1;
+		uint64_t base = bucket - shift * HISTOGRAM_SUB_BUCKETS;
+
+		return ((base + 1) << shift) - 1;
+	}
+}
+
+void FrameHistogram::record(uint64_t micros)
+{
+	m_counts[bucketOf(micros)]++;
+	m_count++;
+	m_max = (micros > m_max) ? micros : m_max;
+}
+
+void FrameHistogram::add(const FrameHistogram& other)
+{
+	for (int i = 0; i < HISTOGRAM_BUCKETS; i++)
+	{
+		m_counts[i] += other.m_counts[i];
+	}
+	m_count += other.m_count;
+	m_max = (other.m_max > m_max) ? other.m_max : m_max;
+}
+
+void FrameHistogram::clear()
+{
+	*this = FrameHistogram();
+}
+
+uint64_t FrameHistogram::count() const
+{
+	return m_count;
+}
+
+uint64_t FrameHistogram::max() const
+{
+	return m_max;
+}
+
+uint64_t FrameHistogram::quantile(double q) const
+{
+	if ( m_count == 0 )
+	{
+		return 0;
+	}
+	uint64_t rank = q * (m_count - 1);
+	uint64_t seen = 0;
+	for (int i = 0; i < HISTOGRAM_BUCKETS; i++)
+	{
+		seen += m_counts[i];
+		if ( seen > rank )
+		{
+			uint64_t top = bucketTop(i);
+			return (top < m_max) ? top : m_max;
+		}
+	}
+
+	return m_max;
+}
+
+HitchDetector::HitchDetector(size_t windowFrames)
+	: m_windowFrames((windowFrames) ? windowFrames : 1), m_cooldown(0), m_sinceCapture(0)
+{
+}
+
+void HitchDetector::setBudget(uint64_t micros, size_t historyFrames)
+{
+	m_budget = micros;
+	m_cooldown = historyFrames;
+	m_sinceCapture = historyFrames;
+	m_inputs.assign((historyFrames) ? historyFrames : 1, InputFrame());
+	m_inputHead = 0;
+	m_inputCount = 0;
+}
+
+bool HitchDetector::frame(uint64_t micros)
+{
+	if ( m_windows[m_current].count() >= m_windowFrames )
+	{
+		m_current = 1 - m_current;
+		m_windows[m_current].clear();
+	}
+	m_windows[m_current].record(micros);
+	m_sinceCapture++;
+	if ( m_budget == 0 || micros <= m_budget )
+	{
+		return false;
+	}
+	m_hitches++;
+	if ( m_sinceCapture < m_cooldown || m_captures >= MAX_CAPTURES )
+	{
+		return false;
+	}
+	m_sinceCapture = 0;
+	m_captures++;
+
+	return true;
+}
+
+void HitchDetector::input(const InputFrame& input)
+{
+	if ( m_inputs.empty() )
+	{
+		return;
+	}
+	m_inputs[m_inputHead] = input;
+	m_inputHead = (m_inputHead + 1) % m_inputs.size();
+	m_inputCount = (m_inputCount < m_inputs.size()) ? m_inputCount + 1 : m_inputCount;
+}
+
+std::vector< InputFrame > HitchDetector::inputs() const
+{
+	std::vector< InputFrame > out;
+	out.reserve(m_inputCount);
+	size_t start = (m_inputHead + m_inputs.size() - m_inputCount) % ((m_inputs.empty()) ? 1 : m_inputs.size());
+	for (size_t i = 0; i < m_inputCount; i++)
+	{
+		out.push_back(m_inputs[(start + i) % m_inputs.size()]);
+	}
+
+	return out;
+}
+
+FrameHistogram HitchDetector::histogram() const
+{
+	FrameHistogram both = m_windows[0];
+	both.add(m_windows[1]);
+
+	return both;
+}
+
+uint64_t HitchDetector::budget() const
+{
+	return m_budget;
+}
+
+size_t HitchDetector::hitches() const
+{
+	return m_hitches;
+}
+
+size_t HitchDetector::captures() const
+{
+	return m_captures;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Replay.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+const int HISTOGRAM_SUB_BUCKETS = 32; // per power of two, so values are kept to within about 3%
+const int HISTOGRAM_SHIFTS = 27; // values up to 2^32 microseconds, over an hour
+const int HISTOGRAM_BUCKETS = (HISTOGRAM_SHIFTS + 1) * HISTOGRAM_SUB_BUCKETS;
+
+// HDR style histogram of frame times in microseconds. Exact up to 64us, then buckets double in width every power of
+// two so a fixed few KB covers everything from a fast tick to a stall with the same relative precision
+class FrameHistogram
+{
+private:
+	uint32_t m_counts[HISTOGRAM_BUCKETS] = {};
+	uint64_t m_count = 0;
+	uint64_t m_max = 0;
+public:
+	void record(uint64_t micros);
+	void add(const FrameHistogram& other);
+	void clear();
+	uint64_t count() const;
+	uint64_t max() const;
+	uint64_t quantile(double q) const; // the top of the bucket the qth frame falls in
+};
+
+// frame times over the last one to two windows, the older window is dropped each time a new one fills. Frames over
+// the budget are hitches, and the input of the last few seconds is kept so a hitch can be captured with what led to it
+class HitchDetector
+{
+private:
+	FrameHistogram m_windows[2];
+	size_t m_current = 0;
+	size_t m_windowFrames;
+	uint64_t m_budget = 0; // microseconds, 0 for no hitch detection
+	size_t m_cooldown; // frames after a capture before the next, so one stall doesn't fill the disk
+	size_t m_sinceCapture;
+	size_t m_hitches = 0;
+	size_t m_captures = 0;
+	std::vector< InputFrame > m_inputs;
+	size_t m_inputHead = 0;
+	size_t m_inputCount = 0;
+public:
+	HitchDetector(size_t windowFrames = 600);
+	void setBudget(uint64_t micros, size_t historyFrames); // historyFrames of input are kept, and captures are that far apart
+	bool frame(uint64_t micros); // true when this frame should be captured
+	void input(const InputFrame& input);
+	std::vector< InputFrame > inputs() const; // oldest first
+	FrameHistogram histogram() const;
+	uint64_t budget() const;
+	size_t hitches() const;
+	size_t captures() const;
+};
@@ -0,0 +1,188 @@
+#include "Log.h"
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#if !defined(PLATFORM_WEB)
+	#include <atomic>
+	#include <chrono>
+	#include <memory>
+	#include <mutex>
+	#include <string>
+	#include <thread>
+	#include <vector>
+#endif
+
+namespace
+{
+	const char* const levelPrefix[] = {"", "", "warning: ", "error: "};
+
+#if !defined(PLATFORM_WEB)
+	struct LogRecord
+	{
+		uint16_t length;
+		char text[LOG_LINE];
+	};
+
+	// single producer, single consumer: the thread it belongs to pushes, the drain thread pops
+	struct LogRing
+	{
+		LogRecord slots[LOG_SLOTS];
+		std::atomic< size_t > head{0}; // next slot the producer writes
+		std::atomic< size_t > tail{0}; // next slot the drain thread reads
+		std::atomic< size_t > dropped{0};
+		size_t reported = 0; // drops already mentioned, drain thread only
+	};
+
+	class Logger
+	{
+	private:
+		std::mutex m_lock; // only taken when a thread logs for the first time, and by the drain thread to list the rings
+		std::vector< std::unique_ptr< LogRing > > m_rings;
+		std::thread m_thread;
+		std::atomic< bool > m_quit{false};
+		std::string m_out;
+		std::vector< std::pair< LogRing*, size_t > > m_read; // where each ring's tail moves to once the text's written
+
+		bool drain()
+		{
+			m_out.clear();
+			m_read.clear();
+			{
+				std::lock_guard< std::mutex > lock(m_lock);
+				for (auto& ring : m_rings)
+				{
+					size_t tail = ring->tail.load(std::memory_order_relaxed);
+					size_t head = ring->head.load(std::memory_order_acquire);
+					for (; tail != head; tail++)
+					{
+						const LogRecord& record = ring->slots[tail % LOG_SLOTS];
+						m_out.append(record.text, record.length);
+						m_out.push_back('\n');
+					}
+					size_t dropped = ring->dropped.load(std::memory_order_relaxed);
+					if ( dropped != ring->reported )
+					{
+						m_out += "(" + std::to_string(dropped - ring->reported) + " log messages dropped)\n";
+						ring->reported = dropped;
+					}
+					m_read.push_back(std::make_pair(ring.get(), head));
+				}
+			}
+			if ( !m_out.empty() )
+			{
+				fwrite(m_out.data(), 1, m_out.size(), stdout);
+				fflush(stdout);
+			}
+			// only now are the slots free, so logFlush() can't return before its messages are out
+			for (auto& read : m_read)
+			{
+				read.first->tail.store(read.second, std::memory_order_release);
+			}
+
+			return !m_out.empty();
+		}
+
+		void loop()
+		{
+			while ( !m_quit )
+			{
+				if ( !drain() )
+				{
+					std::this_thread::sleep_for(std::chrono::milliseconds(2));
+				}
+			}
+			drain();
+		}
+	public:
+		~Logger()
+		{
+			m_quit = true;
+			if ( m_thread.joinable() )
+			{
+				m_thread.join();
+			}
+		}
+
+		LogRing* add()
+		{
+			std::lock_guard< std::mutex > lock(m_lock);
+			m_rings.push_back(std::make_unique< LogRing >());
+			if ( !m_thread.joinable() )
+			{
+				m_thread = std::thread(&Logger::loop, this);
+			}
+
+			return m_rings.back().get();
+		}
+
+		bool pending()
+		{
+			std::lock_guard< std::mutex > lock(m_lock);
+			for (auto& ring : m_rings)
+			{
+				if ( ring->tail.load(std::memory_order_acquire) != ring->head.load(std::memory_order_relaxed) )
+				{
+					return true;
+				}
+			}
+
+			return false;
+		}
+	};
+
+	Logger& logger()
+	{
+		static Logger instance;
+		return instance;
+	}
+#endif
+}
+
+#if defined(PLATFORM_WEB)
+// no threads on the web, write straight away
+void logWrite(LogLevel level, const char* format, ...)
+{
+	char text[LOG_LINE];
+	va_list args;
+	va_start(args, format);
+	vsnprintf(text, sizeof(text), format, args);
+	va_end(args);
+	printf("%s%s\n", levelPrefix[level], text);
+}
+
+void logFlush()
+{
+	fflush(stdout);
+}
+#else
+void logWrite(LogLevel level, const char* format, ...)
+{
+	thread_local LogRing* ring = logger().add();
+	size_t head = ring->head.load(std::memory_order_relaxed);
+	if ( head - ring->tail.load(std::memory_order_acquire) >= LOG_SLOTS )
+	{
+		ring->dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	LogRecord& record = ring->slots[head % LOG_SLOTS];
+	size_t prefix = strlen(levelPrefix[level]);
+	memcpy(record.text, levelPrefix[level], prefix);
+	va_list args;
+	va_start(args, format);
+	int length = vsnprintf(record.text + prefix, LOG_LINE - prefix, format, args);
+	va_end(args);
+	length = (length < 0) ? 0 : length;
+	record.length = ((size_t)length < LOG_LINE - prefix) ? prefix + length : LOG_LINE - 1;
+	ring->head.store(head + 1, std::memory_order_release);
+}
+
+void logFlush()
+{
+	while ( logger().pending() )
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	fflush(stdout);
+}
+#endif
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stddef.h>
+
+enum LogLevel
+{
+	LOG_LEVEL_DEBUG = 0,
+	LOG_LEVEL_INFO = 1,
+	LOG_LEVEL_WARN = 2,
+	LOG_LEVEL_ERROR = 3
+};
+
+// messages below this are compiled out, arguments and all. The makefile lowers it to debug for BUILD_MODE=DEBUG
+#if !defined(SW_LOG_LEVEL)
+	#define SW_LOG_LEVEL 1
+#endif
+
+const size_t LOG_LINE = 128; // longer messages are cut short
+const size_t LOG_SLOTS = 1024; // per thread, messages are dropped and counted while a thread's ring is full
+
+// formats into the calling thread's ring, which a background thread drains to stdout. Never blocks or flushes
+void logWrite(LogLevel level, const char* format, ...) __attribute__((format(printf, 2, 3)));
+// blocks until every message logged so far has been written, so it lands before whatever's printed next
+void logFlush();
+
+#define SW_LOG(level, ...) do { if ( (level) >= SW_LOG_LEVEL ) logWrite((level), __VA_ARGS__); } while ( 0 )
+#define SW_DEBUG(...) SW_LOG(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define SW_INFO(...) SW_LOG(LOG_LEVEL_INFO, __VA_ARGS__)
+#define SW_WARN(...) SW_LOG(LOG_LEVEL_WARN, __VA_ARGS__)
+#define SW_ERROR(...) SW_LOG(LOG_LEVEL_ERROR, __VA_ARGS__)
@@ -0,0 +1,230 @@
+#include "Metrics.h"
+#include <stdio.h>
+#include <string.h>
+#if !defined(PLATFORM_WEB)
+	#include <sys/socket.h>
+	#include <netinet/in.h>
+	#include <arpa/inet.h>
+	#include <poll.h>
+	#include <unistd.h>
+#endif
+
+namespace
+{
+	void metric(std::string& out, const char* name, const char* type, const char* help)
+	{
+		out += "# HELP shape_wars_";
+		out += name;
+		out += " ";
+		out += help;
+		out += "\n# TYPE shape_wars_";
+		out += name;
+		out += " ";
+		out += type;
+		out += "\n";
+	}
+
+	void sample(std::string& out, const char* name, const char* label, const char* value, double v)
+	{
+		char line[160];
+		if ( label )
+		{
+			snprintf(line, sizeof(line), "shape_wars_%s{%s=\"%s\"} %.9g\n", name, label, value, v);
+		}
+		else
+		{
+			snprintf(line, sizeof(line), "shape_wars_%s %.9g\n", name, v);
+		}
+		out += line;
+	}
+}
+
+std::string formatMetrics(const MetricsSnapshot& snapshot)
+{
+	static const char* const quantiles[4] = {"0.5", "0.9", "0.99", "1"};
+	std::string out;
+	metric(out, "frame_seconds", "gauge", "Frame time quantiles over the last 600 to 1200 frames, 1 is the slowest");
+	for (int q = 0; q < 4; q++)
+	{
+		sample(out, "frame_seconds", "quantile", quantiles[q], snapshot.frameSeconds[q]);
+	}
+	if ( snapshot.systems )
+	{
+		metric(out, "system_seconds", "gauge", "Average time each system took over its last 256 runs");
+		for (int s = 0; s < PROF_COUNT; s++)
+		{
+			sample(out, "system_seconds", "system", profSystemNames[s], snapshot.systemSeconds[s]);
+		}
+	}
+	metric(out, "entities", "gauge", "Live entities by tag");
+	for (size_t t = 0; t < snapshot.tagCount; t++)
+	{
+		sample(out, "entities", "tag", snapshot.tags[t], snapshot.entities[t]);
+	}
+	metric(out, "spawned_total", "counter", "Entities added to the world");
+	sample(out, "spawned_total", nullptr, nullptr, snapshot.spawned);
+	metric(out, "despawned_total", "counter", "Entities removed from the world");
+	sample(out, "despawned_total", nullptr, nullptr, snapshot.despawned);
+	metric(out, "shapes", "gauge", "Shapes in the last frame drawn, by whether they were on screen");
+	sample(out, "shapes", "state", "drawn", snapshot.shapesDrawn);
+	sample(out, "shapes", "state", "culled", snapshot.shapesCulled);
+	if ( snapshot.allocs )
+	{
+		metric(out, "allocations_per_frame", "gauge", "Average heap allocations per frame over the last 256 frames");
+		sample(out, "allocations_per_frame", nullptr, nullptr, snapshot.allocsPerFrame);
+		metric(out, "allocated_bytes_per_frame", "gauge", "Average bytes allocated per frame over the last 256 frames");
+		sample(out, "allocated_bytes_per_frame", nullptr, nullptr, snapshot.allocBytesPerFrame);
+	}
+	metric(out, "score", "gauge", "Current score");
+	sample(out, "score", nullptr, nullptr, snapshot.score);
+	metric(out, "high_score", "gauge", "High score this session");
+	sample(out, "high_score", nullptr, nullptr, snapshot.highScore);
+	metric(out, "frame", "gauge", "Frames since the player last spawned");
+	sample(out, "frame", nullptr, nullptr, snapshot.frame);
+	metric(out, "ticks_total", "counter", "Ticks simulated since start up");
+	sample(out, "ticks_total", nullptr, nullptr, snapshot.ticks);
+
+	return out;
+}
+
+MetricsServer::~MetricsServer()
+{
+	close();
+}
+
+// the game's slot goes to the middle and it takes back whichever slot was there
+void MetricsServer::publish(const MetricsSnapshot& snapshot)
+{
+	m_slots[m_back] = snapshot;
+	m_back = m_middle.exchange(m_back | FRESH, std::memory_order_acq_rel) & 3;
+}
+
+size_t MetricsServer::scrapes() const
+{
+	return m_scrapes;
+}
+
+#if defined(PLATFORM_WEB)
+// no sockets or threads in the browser
+bool MetricsServer::listen(uint16_t port)
+{
+	return false;
+}
+
+void MetricsServer::serve()
+{
+}
+
+void MetricsServer::respond(int socket)
+{
+}
+
+void MetricsServer::close()
+{
+}
+#else
+bool MetricsServer::listen(uint16_t port)
+{
+	close();
+	m_listen = socket(AF_INET, SOCK_STREAM, 0);
+	if ( m_listen < 0 )
+	{
+		return false;
+	}
+	int yes = 1;
+	setsockopt(m_listen, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+	// only this machine, a kiosk's agent scrapes it and forwards
+	sockaddr_in local = {};
+	local.sin_family = AF_INET;
+	local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	local.sin_port = htons(port);
+	if ( ::bind(m_listen, (sockaddr*)&local, sizeof(local)) < 0 || ::listen(m_listen, 16) < 0 )
+	{
+		close();
+		return false;
+	}
+	m_quit = false;
+	m_thread = std::thread(&MetricsServer::serve, this);
+
+	return true;
+}
+
+void MetricsServer::serve()
+{
+	pollfd listener = {m_listen, POLLIN, 0};
+	while ( !m_quit )
+	{
+		// wakes up now and then to see if it's time to stop
+		if ( poll(&listener, 1, 100) <= 0 )
+		{
+			continue;
+		}
+		int socket = ::accept(m_listen, nullptr, nullptr);
+		if ( socket >= 0 )
+		{
+			respond(socket);
+			::close(socket);
+		}
+	}
+}
+
+// one request per connection, anything but a GET of /metrics is a 404
+void MetricsServer::respond(int socket)
+{
+	char request[1024];
+	size_t got = 0;
+	pollfd client = {socket, POLLIN, 0};
+	while ( got < sizeof(request) - 1 && poll(&client, 1, 1000) > 0 )
+	{
+		ssize_t read = recv(socket, request + got, sizeof(request) - 1 - got, 0);
+		if ( read <= 0 )
+		{
+			break;
+		}
+		got += read;
+		request[got] = '\0';
+		if ( strstr(request, "\r\n\r\n") )
+		{
+			break;
+		}
+	}
+	request[got] = '\0';
+	std::string body;
+	const char* status = "404 Not Found";
+	if ( strncmp(request, "GET /metrics ", 13) == 0 || strncmp(request, "GET /metrics?", 13) == 0 )
+	{
+		if ( m_middle.load(std::memory_order_relaxed) & FRESH )
+		{
+			m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & 3;
+		}
+		body = formatMetrics(m_slots[m_front]);
+		status = "200 OK";
+		m_scrapes++;
+	}
+	std::string response = std::string("HTTP/1.1 ") + status + "\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+	size_t sent = 0;
+	while ( sent < response.size() )
+	{
+		ssize_t wrote = send(socket, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+		if ( wrote <= 0 )
+		{
+			break;
+		}
+		sent += wrote;
+	}
+}
+
+void MetricsServer::close()
+{
+	m_quit = true;
+	if ( m_thread.joinable() )
+	{
+		m_thread.join();
+	}
+	if ( m_listen >= 0 )
+	{
+		::close(m_listen);
+	}
+	m_listen = -1;
+}
+#endif
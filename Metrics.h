@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Profiler.h"
+#include <atomic>
+#include <string>
+#include <stdint.h>
+#include <stddef.h>
+#if !defined(PLATFORM_WEB)
+	#include <thread>
+#endif
+
+const size_t METRICS_TAGS = 8; // entity tags counted
+const int METRICS_INTERVAL_MS = 250; // how often the game publishes, scrapers see values at most this old
+
+// what a scrape reports, all plain values so the game can fill one without allocating
+struct MetricsSnapshot
+{
+	double frameSeconds[4] = {}; // p50, p90, p99 and max of the rolling frame time histogram
+	bool systems = false; // PROFILE=TRUE builds only
+	double systemSeconds[PROF_COUNT] = {}; // average per run
+	const char* tags[METRICS_TAGS] = {}; // string literals
+	size_t entities[METRICS_TAGS] = {};
+	size_t tagCount = 0;
+	uint64_t spawned = 0; // totals, Prometheus' rate() makes them per second
+	uint64_t despawned = 0;
+	size_t shapesDrawn = 0; // in the last frame drawn, after culling
+	size_t shapesCulled = 0;
+	bool allocs = false; // ALLOCS=TRUE builds only
+	double allocsPerFrame = 0;
+	double allocBytesPerFrame = 0;
+	int64_t score = 0;
+	int64_t highScore = 0;
+	int64_t frame = 0; // m_currentFrame, back to 0 on every respawn
+	uint64_t ticks = 0;
+};
+
+// serves the latest snapshot in Prometheus' text format over HTTP on localhost, from its own thread. The game hands
+// snapshots over through a triple buffer, so neither side ever waits on the other however slow a scraper is
+class MetricsServer
+{
+private:
+	static const uint8_t FRESH = 4; // set on the middle slot when the game has published since the last scrape
+	MetricsSnapshot m_slots[3];
+	uint8_t m_back = 0; // the game's
+	std::atomic< uint8_t > m_middle{1};
+	uint8_t m_front = 2; // the server thread's
+	int m_listen = -1;
+	std::atomic< bool > m_quit{false};
+	std::atomic< size_t > m_scrapes{0};
+#if !defined(PLATFORM_WEB)
+	std::thread m_thread;
+#endif
+	void serve();
+	void respond(int socket);
+public:
+	~MetricsServer();
+	bool listen(uint16_t port);
+	void publish(const MetricsSnapshot& snapshot);
+	void close();
+	size_t scrapes() const;
+};
+
+std::string formatMetrics(const MetricsSnapshot& snapshot); // Prometheus text exposition format
@@ -0,0 +1,381 @@
+#include "Net.h"
+#include <iostream>
+#include <chrono>
+#if !defined(PLATFORM_WEB)
+	#include <sys/socket.h>
+	#include <netinet/in.h>
+	#include <arpa/inet.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+NetPeer::~NetPeer()
+{
+	close();
+}
+
+#if defined(PLATFORM_WEB)
+// no UDP in the browser
+bool NetPeer::bind(uint16_t port)
+{
+	return false;
+}
+
+bool NetPeer::connect(const char* address, uint16_t port)
+{
+	return false;
+}
+
+bool NetPeer::send(const uint8_t* data, size_t size)
+{
+	return false;
+}
+
+int NetPeer::receive(uint8_t* data, size_t size)
+{
+	return -1;
+}
+
+void NetPeer::close()
+{
+}
+#else
+bool NetPeer::bind(uint16_t port)
+{
+	close();
+	m_socket = socket(AF_INET, SOCK_DGRAM, 0);
+	if ( m_socket < 0 )
+	{
+		return false;
+	}
+	sockaddr_in local = {};
+	local.sin_family = AF_INET;
+	local.sin_addr.s_addr = htonl(INADDR_ANY);
+	local.sin_port = htons(port);
+	if ( ::bind(m_socket, (sockaddr*)&local, sizeof(local)) < 0 )
+	{
+		close();
+		return false;
+	}
+	fcntl(m_socket, F_SETFL, O_NONBLOCK);
+
+	return true;
+}
+
+bool NetPeer::connect(const char* address, uint16_t port)
+{
+	close();
+	in_addr remote;
+	if ( inet_pton(AF_INET, address, &remote) != 1 )
+	{
+		return false;
+	}
+	m_socket = socket(AF_INET, SOCK_DGRAM, 0);
+	if ( m_socket < 0 )
+	{
+		return false;
+	}
+	fcntl(m_socket, F_SETFL, O_NONBLOCK);
+	m_remoteAddress = remote.s_addr;
+	m_remotePort = htons(port);
+	m_hasRemote = true;
+
+	return true;
+}
+
+bool NetPeer::send(const uint8_t* data, size_t size)
+{
+	if ( m_socket < 0 || !m_hasRemote )
+	{
+		return false;
+	}
+	sockaddr_in remote = {};
+	remote.sin_family = AF_INET;
+	remote.sin_addr.s_addr = m_remoteAddress;
+	remote.sin_port = m_remotePort;
+
+	return sendto(m_socket, data, size, 0, (sockaddr*)&remote, sizeof(remote)) == (ssize_t)size;
+}
+
+int NetPeer::receive(uint8_t* data, size_t size)
+{
+	if ( m_socket < 0 )
+	{
+		return -1;
+	}
+	sockaddr_in from = {};
+	socklen_t length = sizeof(from);
+	ssize_t got = recvfrom(m_socket, data, size, 0, (sockaddr*)&from, &length);
+	if ( got < 0 )
+	{
+		return -1;
+	}
+	if ( !m_hasRemote )
+	{
+		m_remoteAddress = from.sin_addr.s_addr;
+		m_remotePort = from.sin_port;
+		m_hasRemote = true;
+	}
+
+	return got;
+}
+
+void NetPeer::close()
+{
+	if ( m_socket >= 0 )
+	{
+		::close(m_socket);
+	}
+	m_socket = -1;
+	m_hasRemote = false;
+}
+#endif
+
+bool NetPeer::hasRemote() const
+{
+	return m_hasRemote;
+}
+
+bool NetSession::host(uint16_t port, uint64_t seed)
+{
+	m_seed = seed;
+	m_slot = 0;
+
+	return m_peer.bind(port);
+}
+
+bool NetSession::join(const char* address, uint16_t port, double timeout)
+{
+	m_slot = 1;
+	if ( !m_peer.connect(address, port) )
+	{
+		return false;
+	}
+	// the host can't answer until it has heard from us, keep saying hello until it does and tells us the seed
+	auto start = std::chrono::steady_clock::now();
+	uint8_t buffer[1024];
+	while ( std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < timeout )
+	{
+		send();
+		int got;
+		while ( (got = m_peer.receive(buffer, sizeof(buffer))) >= 0 )
+		{
+			ByteReader in(buffer, got);
+			if ( in.u32() == NET_MAGIC )
+			{
+				m_seed = in.u64();
+				handle(in);
+				return true;
+			}
+		}
+#if !defined(PLATFORM_WEB)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+#endif
+	}
+
+	return false;
+}
+
+void NetSession::pushLocal(const InputFrame& input)
+{
+	m_local.push_back(input);
+	send();
+}
+
+void NetSession::send()
+{
+	// the other side can't use anything past a gap, so always start from the oldest input they haven't acknowledged
+	size_t first = m_acked;
+	size_t count = (m_local.size() - first < NET_MAX_INPUTS) ? m_local.size() - first : NET_MAX_INPUTS;
+	ByteWriter out;
+	out.u32(NET_MAGIC);
+	out.u64(m_seed);
+	out.varint(m_remote.size());
+	out.varint(first);
+	out.u8(count);
+	for (size_t t = first; t < first + count; t++)
+	{
+		out.u8(m_local[t].buttons);
+		out.i16(m_local[t].mouseX);
+		out.i16(m_local[t].mouseY);
+	}
+	m_peer.send(out.buffer(), out.size());
+}
+
+void NetSession::poll()
+{
+	uint8_t buffer[1024];
+	int got;
+	bool heard = false;
+	while ( (got = m_peer.receive(buffer, sizeof(buffer))) >= 0 )
+	{
+		ByteReader in(buffer, got);
+		if ( in.u32() != NET_MAGIC )
+		{
+			continue;
+		}
+		uint64_t seed = in.u64();
+		if ( seed != m_seed && seed != 0 && m_slot == 0 )
+		{
+			// the host picks the seed and joiners say 0 until they've heard it, anything else is from another game
+			if ( !m_warned )
+			{
+				std::cout << "ignoring packets for a game with seed " << seed << std::endl;
+				m_warned = true;
+			}
+			continue;
+		}
+		handle(in);
+		heard = true;
+	}
+	if ( heard )
+	{
+		// answer straight away, so a joiner saying hello learns the seed and the other side's acks stay fresh while we wait
+		send();
+	}
+}
+
+void NetSession::handle(ByteReader& in)
+{
+	size_t ack = in.varint();
+	size_t first = in.varint();
+	size_t count = in.u8();
+	if ( !in.ok() )
+	{
+		return;
+	}
+	m_packets++;
+	m_acked = (ack > m_acked && ack <= m_local.size()) ? ack : m_acked;
+	for (size_t i = 0; i < count; i++)
+	{
+		InputFrame input;
+		input.buttons = in.u8();
+		input.mouseX = in.i16();
+		input.mouseY = in.i16();
+		size_t tick = first + i;
+		if ( !in.ok() || tick > m_remote.size() )
+		{
+			break; // a gap, the packet after the lost one will fill it
+		}
+		if ( tick < m_remote.size() )
+		{
+			continue; // already have it
+		}
+		m_remote.push_back(input);
+		if ( tick < m_guesses.size() && m_guesses[tick] != input && tick < m_firstWrong )
+		{
+			m_firstWrong = tick;
+		}
+	}
+}
+
+const InputFrame& NetSession::local(size_t tick) const
+{
+	return m_local[tick];
+}
+
+InputFrame NetSession::remote(size_t tick)
+{
+	InputFrame input;
+	if ( tick < m_remote.size() )
+	{
+		input = m_remote[tick];
+	}
+	else if ( !m_remote.empty() )
+	{
+		input = m_remote.back();
+	}
+	if ( tick >= m_guesses.size() )
+	{
+		m_guesses.resize(tick + 1);
+	}
+	m_guesses[tick] = input;
+
+	return input;
+}
+
+size_t NetSession::confirmed() const
+{
+	return m_remote.size();
+}
+
+size_t NetSession::mispredicted()
+{
+	size_t wrong = m_firstWrong;
+	m_firstWrong = (size_t)-1;
+
+	return wrong;
+}
+
+size_t NetSession::packets() const
+{
+	return m_packets;
+}
+
+uint64_t NetSession::seed() const
+{
+	return m_seed;
+}
+
+int NetSession::slot() const
+{
+	return m_slot;
+}
+
+#if !defined(PLATFORM_WEB)
+LoopbackBot::LoopbackBot(uint16_t port, int fps, double delay, uint64_t seed)
+	: m_port(port), m_fps(fps), m_delay(delay), m_seed(seed) {}
+
+LoopbackBot::~LoopbackBot()
+{
+	stop();
+}
+
+void LoopbackBot::start()
+{
+	m_quit = false;
+	m_thread = std::thread(&LoopbackBot::loop, this);
+}
+
+void LoopbackBot::stop()
+{
+	m_quit = true;
+	if ( m_thread.joinable() )
+	{
+		m_thread.join();
+	}
+}
+
+void LoopbackBot::loop()
+{
+	NetSession session;
+	if ( !session.join("127.0.0.1", m_port) )
+	{
+		std::cout << "loopback bot could not reach port " << m_port << std::endl;
+		return;
+	}
+	Rng rng(m_seed, 0);
+	InputFrame input;
+	auto start = std::chrono::steady_clock::now();
+	size_t tick = 0;
+	while ( !m_quit )
+	{
+		session.poll();
+		// tick t's input goes out delay seconds after tick t should have happened
+		double now = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		while ( tick < (now - m_delay) * m_fps )
+		{
+			// buttons are held for a while like a person would, so most guesses are right
+			if ( rng.range(0, 7) == 0 )
+			{
+				input.buttons = rng.next() & ~INPUT_PAUSE;
+				input.mouseX = rng.range(0, 1279);
+				input.mouseY = rng.range(0, 719);
+			}
+			session.pushLocal(input);
+			tick++;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+	}
+}
+#endif
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Replay.h"
+#include "Random.h"
+#if !defined(PLATFORM_WEB)
+	#include <thread>
+	#include <atomic>
+#endif
+
+const uint32_t NET_MAGIC = 0x504e5753; // "SWNP"
+const size_t NET_MAX_INPUTS = 128; // unacknowledged inputs are resent in every packet, oldest first, up to this many
+
+// non-blocking UDP socket to the other player. The host learns the other end's address from the first packet it gets
+class NetPeer
+{
+private:
+	int m_socket = -1;
+	uint32_t m_remoteAddress = 0; // network byte order
+	uint16_t m_remotePort = 0;
+	bool m_hasRemote = false;
+public:
+	~NetPeer();
+	bool bind(uint16_t port);
+	bool connect(const char* address, uint16_t port);
+	bool send(const uint8_t* data, size_t size);
+	int receive(uint8_t* data, size_t size); // -1 when nothing is waiting
+	void close();
+	bool hasRemote() const;
+};
+
+// both players' inputs for a two player game. Every tick each side sends its newest inputs, and the other side's
+// input for a tick it hasn't heard about yet is predicted by repeating the last one it did hear.
+// Each packet: magic, seed, ack (their ticks we have), first tick, count, then count input frames
+class NetSession
+{
+private:
+	NetPeer m_peer;
+	uint64_t m_seed = 0;
+	int m_slot = 0; // 0 hosts and plays the first player, 1 joined and plays the second
+	std::vector< InputFrame > m_local; // ours for every tick so far
+	std::vector< InputFrame > m_remote; // theirs, confirmed and without gaps
+	std::vector< InputFrame > m_guesses; // what each simulated tick used for theirs
+	size_t m_acked = 0; // they have ours for every tick below this
+	size_t m_firstWrong = (size_t)-1;
+	size_t m_packets = 0;
+	bool m_warned = false;
+	void send();
+	void handle(ByteReader& in);
+public:
+	bool host(uint16_t port, uint64_t seed);
+	bool join(const char* address, uint16_t port, double timeout = 5); // takes the host's seed
+	void pushLocal(const InputFrame& input); // ours for the next tick, sent straight away
+	void poll();
+	const InputFrame& local(size_t tick) const;
+	InputFrame remote(size_t tick); // confirmed, or a guess that's checked once the real one arrives
+	size_t confirmed() const; // ticks we have their input for
+	size_t mispredicted(); // earliest tick simulated with a wrong guess and forgets it, -1 if there isn't one
+	size_t packets() const;
+	uint64_t seed() const;
+	int slot() const;
+};
+
+#if !defined(PLATFORM_WEB)
+// stands in for a remote player in tests: joins over loopback and plays random held inputs in real time, sending
+// each tick's input late by a fixed delay so the host has to predict and roll back
+class LoopbackBot
+{
+private:
+	std::thread m_thread;
+	std::atomic< bool > m_quit{false};
+	uint16_t m_port;
+	int m_fps;
+	double m_delay;
+	uint64_t m_seed;
+	void loop();
+public:
+	LoopbackBot(uint16_t port, int fps, double delay = 0.1, uint64_t seed = 1);
+	~LoopbackBot();
+	void start();
+	void stop();
+};
+#endif
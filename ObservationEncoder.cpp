@@ -0,0 +1,94 @@
+#include "ObservationEncoder.h"
+#include <algorithm>
+#include <string.h>
+
+ObservationEncoder::ObservationEncoder(const ObsConfig& config)
+	: m_config(config)
+{
+	size_t most = std::max(std::max(config.enemies, config.debris), config.bullets);
+	m_found.resize(most);
+	m_distSq.resize(most);
+}
+
+size_t ObservationEncoder::size() const
+{
+	return OBS_PLAYER_SIZE + (m_config.enemies + m_config.debris + m_config.bullets) * OBS_ENTITY_SIZE + m_config.rasterWidth * m_config.rasterHeight;
+}
+
+void ObservationEncoder::encode(Game& game, float* out)
+{
+	const GameConfig& config = game.config;
+	const Entity& player = *game.m_player;
+	if ( m_window.x != config.window.width || m_window.y != config.window.height )
+	{
+		m_window = (Vector2) {(float)config.window.width, (float)config.window.height};
+		m_enemies.resize(m_window.x, m_window.y, m_config.cellSize);
+		m_debris.resize(m_window.x, m_window.y, m_config.cellSize);
+		m_bullets.resize(m_window.x, m_window.y, m_config.cellSize);
+	}
+	EntityVec& enemies = game.m_entities.getEntities("Enemy");
+	EntityVec& debris = game.m_entities.getEntities("Debris");
+	Vector2 origin = player.cTransform->pos;
+	out[OBS_PLAYER_X] = origin.x / config.window.width;
+	out[OBS_PLAYER_Y] = origin.y / config.window.height;
+	out[OBS_PLAYER_VX] = player.cTransform->velocity.x / config.player.speed;
+	out[OBS_PLAYER_VY] = player.cTransform->velocity.y / config.player.speed;
+	out[OBS_DASH_ACTIVE] = player.cDash->active;
+	out[OBS_DASH_READY] = !player.cDash->active && game.m_currentFrame >= player.cDash->frameStarted + player.cDash->frames + player.cDash->delay;
+	out[OBS_TIME] = game.m_currentFrame / (float)(config.window.fps * 60);
+	out[OBS_ENEMIES] = enemies.size() / 100.0f;
+	out += OBS_PLAYER_SIZE;
+	m_enemies.build(enemies);
+	m_debris.build(debris);
+	m_bullets.build(game.m_entities.getEntities("Bullet"));
+	encodeNearest(m_enemies, origin, m_config.enemies, config.enemy.speed, config, out);
+	out += m_config.enemies * OBS_ENTITY_SIZE;
+	encodeNearest(m_debris, origin, m_config.debris, config.enemy.speed, config, out);
+	out += m_config.debris * OBS_ENTITY_SIZE;
+	encodeNearest(m_bullets, origin, m_config.bullets, config.bullet.speed, config, out);
+	out += m_config.bullets * OBS_ENTITY_SIZE;
+	if ( m_config.rasterWidth > 0 && m_config.rasterHeight > 0 )
+	{
+		size_t cells = m_config.rasterWidth * m_config.rasterHeight;
+		memset(out, 0, cells * sizeof(float));
+		encodeRaster(enemies, config, out);
+		encodeRaster(debris, config, out);
+	}
+}
+
+void ObservationEncoder::encodeNearest(const SpatialGrid& grid, Vector2 origin, size_t k, float speed, const GameConfig& config, float* out)
+{
+	size_t found = grid.nearest(origin, k, m_found.data(), m_distSq.data());
+	memset(out, 0, k * OBS_ENTITY_SIZE * sizeof(float));
+	for (size_t i = 0; i < found; i++)
+	{
+		const Entity& e = *m_found[i]->entity;
+		float* slot = out + i * OBS_ENTITY_SIZE;
+		slot[OBS_PRESENT] = 1;
+		slot[OBS_DX] = (e.cTransform->pos.x - origin.x) / config.window.width;
+		slot[OBS_DY] = (e.cTransform->pos.y - origin.y) / config.window.height;
+		slot[OBS_VX] = e.cTransform->velocity.x / speed;
+		slot[OBS_VY] = e.cTransform->velocity.y / speed;
+		if ( e.cShape )
+		{
+			slot[OBS_RADIUS] = e.cShape->radius / config.enemy.radius;
+			slot[OBS_SIDES] = e.cShape->sides / 8.0f;
+		}
+	}
+}
+
+void ObservationEncoder::encodeRaster(const EntityVec& entities, const GameConfig& config, float* out)
+{
+	float scaleX = m_config.rasterWidth / (float)config.window.width;
+	float scaleY = m_config.rasterHeight / (float)config.window.height;
+	for (const auto& e : entities)
+	{
+		if ( !e->cTransform )
+		{
+			continue;
+		}
+		int x = std::min(std::max((int)(e->cTransform->pos.x * scaleX), 0), m_config.rasterWidth - 1);
+		int y = std::min(std::max((int)(e->cTransform->pos.y * scaleY), 0), m_config.rasterHeight - 1);
+		out[y * m_config.rasterWidth + x] = 1;
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Game.h"
+#include "SpatialGrid.h"
+
+// player features at the start of every observation
+enum ObsFeature
+{
+	OBS_PLAYER_X, // 0 to 1 across the window
+	OBS_PLAYER_Y,
+	OBS_PLAYER_VX, // -1 to 1 of the player's speed
+	OBS_PLAYER_VY,
+	OBS_DASH_ACTIVE,
+	OBS_DASH_READY,
+	OBS_TIME, // minutes survived this run
+	OBS_ENEMIES, // live enemies / 100
+	OBS_PLAYER_SIZE
+};
+
+// features of each nearby entity, slots past the last one found are all zero
+enum ObsEntityFeature
+{
+	OBS_PRESENT,
+	OBS_DX, // offset from the player, in window widths/heights
+	OBS_DY,
+	OBS_VX, // in units of the entity type's configured speed
+	OBS_VY,
+	OBS_RADIUS, // in enemy radii
+	OBS_SIDES, // sides / 8
+	OBS_ENTITY_SIZE
+};
+
+struct ObsConfig
+{
+	size_t enemies = 8; // nearest of each kind to report
+	size_t debris = 8;
+	size_t bullets = 2;
+	int rasterWidth = 0; // enemy and debris occupancy over the whole window, 0 turns it off
+	int rasterHeight = 0;
+	float cellSize = 64; // spatial grid cell in pixels
+};
+
+// turns a game into a fixed size float vector for training: player features, then the nearest enemies,
+// debris and bullets, then the optional raster. Scratch space is sized up front and the spatial grids
+// keep their buffers, so encoding doesn't allocate once the grids have seen the busiest tick
+class ObservationEncoder
+{
+private:
+	ObsConfig m_config;
+	SpatialGrid m_enemies;
+	SpatialGrid m_debris;
+	SpatialGrid m_bullets;
+	std::vector< const GridItem* > m_found;
+	std::vector< float > m_distSq;
+	Vector2 m_window = {0, 0}; // the grids are resized when a game with a different window comes along
+	void encodeNearest(const SpatialGrid& grid, Vector2 origin, size_t k, float speed, const GameConfig& config, float* out);
+	void encodeRaster(const EntityVec& entities, const GameConfig& config, float* out);
+public:
+	ObservationEncoder(const ObsConfig& config = ObsConfig());
+	size_t size() const; // floats written by encode
+	void encode(Game& game, float* out);
+};
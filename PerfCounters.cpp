@@ -0,0 +1,112 @@
+#include "PerfCounters.h"
+#include <atomic>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace
+{
+	std::atomic< bool > enabled{false};
+
+	struct CounterGroup
+	{
+		int leader = -1;
+		bool tried = false;
+	};
+
+	thread_local CounterGroup group;
+
+	int openCounter(uint32_t type, uint64_t config, int leader)
+	{
+		perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = type;
+		attr.config = config;
+		attr.disabled = (leader == -1);
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_GROUP;
+
+		return syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+	}
+
+	// the leader's read returns the whole group, in the order it was opened
+	bool openGroup()
+	{
+		group.tried = true;
+		const uint64_t cache = PERF_COUNT_HW_CACHE_OP_READ << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+		const uint32_t types[PERF_COUNT] = {PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HW_CACHE, PERF_TYPE_HARDWARE};
+		const uint64_t configs[PERF_COUNT] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_L1D | cache, PERF_COUNT_HW_CACHE_LL | cache, PERF_COUNT_HW_BRANCH_MISSES};
+		int fds[PERF_COUNT];
+		for (int i = 0; i < PERF_COUNT; i++)
+		{
+			fds[i] = openCounter(types[i], configs[i], (i) ? fds[0] : -1);
+			if ( fds[i] == -1 )
+			{
+				for (int j = 0; j < i; j++)
+				{
+					close(fds[j]);
+				}
+				return false;
+			}
+		}
+		ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+		ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+		group.leader = fds[0];
+
+		return true;
+	}
+}
+
+bool perfCountersEnable()
+{
+	if ( group.leader == -1 && !openGroup() )
+	{
+		return false;
+	}
+	enabled = true;
+
+	return true;
+}
+
+bool perfCountersEnabled()
+{
+	return enabled.load(std::memory_order_relaxed);
+}
+
+PerfSample perfRead()
+{
+	PerfSample sample;
+	if ( !enabled.load(std::memory_order_relaxed) || (group.leader == -1 && (group.tried || !openGroup())) )
+	{
+		return sample;
+	}
+	uint64_t data[PERF_COUNT + 1]; // how many, then each value
+	if ( read(group.leader, data, sizeof(data)) == (ssize_t)sizeof(data) )
+	{
+		memcpy(sample.values, data + 1, sizeof(sample.values));
+	}
+
+	return sample;
+}
+#else
+bool perfCountersEnable()
+{
+	return false;
+}
+
+bool perfCountersEnabled()
+{
+	return false;
+}
+
+PerfSample perfRead()
+{
+	return PerfSample();
+}
+#endif
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdint.h>
+
+// hardware events counted for each profiled system
+enum PerfCounter
+{
+	PERF_CYCLES,
+	PERF_INSTRUCTIONS,
+	PERF_L1D_MISSES, // L1 data cache read misses
+	PERF_LLC_MISSES, // last level cache misses
+	PERF_BRANCH_MISSES,
+	PERF_COUNT
+};
+
+struct PerfSample
+{
+	uint64_t values[PERF_COUNT] = {};
+};
+
+// Linux hardware counters through perf_event_open, user space only so they work at the default perf_event_paranoid
+// of 2. Each thread opens its own group the first time it reads, after which a single read() gets every counter.
+// Anywhere else, before perfCountersEnable() or when the kernel refuses, reads are all zero
+bool perfCountersEnable(); // false if the counters can't be opened
+bool perfCountersEnabled();
+PerfSample perfRead(); // running totals for the calling thread
@@ -0,0 +1,349 @@
+#include "Random.h"
+#include "include/json/json.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+
+// performance regression gate, built with `make gate`. Runs shape_wars_bench a few times, keeps the results as a
+// baseline named after the git revision and compares new runs against one. A benchmark only fails the gate when the
+// whole bootstrap confidence interval of its slowdown is past the threshold, so noisy benchmarks don't
+struct Metric
+{
+	std::string name;
+	size_t entities = 0;
+	std::vector< double > samples; // nanoseconds per op, pooled over every run
+	double allocs = -1; // per op, the most any run saw. -1 unless the bench was built with ALLOCS=TRUE
+};
+
+// keyed by name and size, so the report comes out grouped by benchmark
+typedef std::map< std::pair< std::string, size_t >, Metric > Metrics;
+
+// how much slower the new median is than the baseline's, as a fraction, with its confidence interval
+struct Change
+{
+	double change = 0;
+	double low = 0;
+	double high = 0;
+};
+
+// first line a shell command prints, empty if it failed
+std::string command(const char* cmd)
+{
+	std::string line;
+	FILE* pipe = popen(cmd, "r");
+	if ( !pipe )
+	{
+		return line;
+	}
+	char buffer[256];
+	if ( fgets(buffer, sizeof(buffer), pipe) )
+	{
+		line = buffer;
+		line.erase(line.find_last_not_of("\r\n") + 1);
+	}
+	pclose(pipe);
+
+	return line;
+}
+
+// short hash of HEAD, marked dirty if tracked files have changed since
+std::string revision()
+{
+	std::string rev = command("git rev-parse --short HEAD 2>/dev/null");
+	if ( rev.empty() )
+	{
+		return "unknown";
+	}
+	if ( !command("git status --porcelain --untracked-files=no 2>/dev/null").empty() )
+	{
+		rev += "-dirty";
+	}
+
+	return rev;
+}
+
+// bench output and baselines are the same shape, the samples are added to whatever's already there
+bool readResults(const std::string& file, Metrics& metrics)
+{
+	std::ifstream input(file);
+	if ( !input )
+	{
+		return false;
+	}
+	nlohmann::json j_results;
+	input >> j_results;
+	if ( !j_results.contains("benchmarks") )
+	{
+		return false;
+	}
+	for (auto& j_bench : j_results["benchmarks"])
+	{
+		std::string name = j_bench["name"];
+		size_t entities = j_bench["entities"];
+		Metric& metric = metrics[std::make_pair(name, entities)];
+		metric.name = name;
+		metric.entities = entities;
+		for (double sample : j_bench["samples_ns"])
+		{
+			metric.samples.push_back(sample);
+		}
+		if ( j_bench.contains("allocs_per_op") )
+		{
+			metric.allocs = std::max(metric.allocs, j_bench["allocs_per_op"].get< double >());
+		}
+	}
+
+	return true;
+}
+
+bool writeBaseline(const std::string& file, const std::string& rev, const Metrics& metrics)
+{
+	nlohmann::json out;
+	out["revision"] = rev;
+	out["benchmarks"] = nlohmann::json::array();
+	for (auto& entry : metrics)
+	{
+		const Metric& metric = entry.second;
+		nlohmann::json j_bench = {
+			{"name", metric.name},
+			{"entities", metric.entities},
+			{"samples_ns", metric.samples}
+		};
+		if ( metric.allocs >= 0 )
+		{
+			j_bench["allocs_per_op"] = metric.allocs;
+		}
+		out["benchmarks"].push_back(j_bench);
+	}
+	std::ofstream output(file, std::ios::trunc);
+	if ( !output )
+	{
+		return false;
+	}
+	output << out.dump(1, '\t') << std::endl;
+
+	return true;
+}
+
+double median(std::vector< double > samples)
+{
+	std::sort(samples.begin(), samples.end());
+	size_t half = samples.size() / 2;
+
+	return (samples.size() % 2) ? samples[half] : (samples[half - 1] + samples[half]) / 2;
+}
+
+// resamples both sets of samples with replacement and takes the spread of the ratio of their medians
+Change bootstrap(const std::vector< double >& base, const std::vector< double >& next, int resamples, double confidence, Rng& rng)
+{
+	Change result;
+	result.change = median(next) / median(base) - 1;
+	std::vector< double > changes(resamples);
+	std::vector< double > a(base.size());
+	std::vector< double > b(next.size());
+	for (int r = 0; r < resamples; r++)
+	{
+		for (double& sample : a)
+		{
+			sample = base[rng.range(0, base.size() - 1)];
+		}
+		for (double& sample : b)
+		{
+			sample = next[rng.range(0, next.size() - 1)];
+		}
+		changes[r] = median(b) / median(a) - 1;
+	}
+	std::sort(changes.begin(), changes.end());
+	double tail = (1 - confidence) / 2;
+	result.low = changes[(size_t)(tail * (resamples - 1))];
+	result.high = changes[(size_t)((1 - tail) * (resamples - 1))];
+
+	return result;
+}
+
+int main(int argc, char* argv[])
+{
+	std::string bench = "./shape_wars_bench";
+	std::string dir = "perf";
+	std::string baseline; // a revision, defaults to the last one recorded
+	std::string results; // compare this bench output instead of running the benchmarks
+	std::string benchArgs;
+	bool record = false;
+	int runs = 3;
+	double threshold = 5; // percent
+	double confidence = 0.95;
+	int resamples = 2000;
+	for (int i = 1; i < argc; i++)
+	{
+		if ( strcmp(argv[i], "--bench") == 0 && i + 1 < argc )
+		{
+			bench = argv[++i];
+		}
+		else if ( strcmp(argv[i], "--dir") == 0 && i + 1 < argc )
+		{
+			dir = argv[++i];
+		}
+		else if ( strcmp(argv[i], "--baseline") == 0 && i + 1 < argc )
+		{
+			baseline = argv[++i];
+		}
+		else if ( strcmp(argv[i], "--results") == 0 && i + 1 < argc )
+		{
+			results = argv[++i];
+		}
+		else if ( strcmp(argv[i], "--record") == 0 )
+		{
+			record = true;
+		}
+		else if ( strcmp(argv[i], "--runs") == 0 && i + 1 < argc )
+		{
+			runs = atoi(argv[++i]);
+			runs = (runs > 0) ? runs : 1;
+		}
+		else if ( strcmp(argv[i], "--threshold") == 0 && i + 1 < argc )
+		{
+			threshold = atof(argv[++i]);
+		}
+		else if ( strcmp(argv[i], "--confidence") == 0 && i + 1 < argc )
+		{
+			confidence = atof(argv[++i]);
+		}
+		else if ( strcmp(argv[i], "--resamples") == 0 && i + 1 < argc )
+		{
+			resamples = atoi(argv[++i]);
+			resamples = (resamples > 0) ? resamples : 1;
+		}
+		else if ( strcmp(argv[i], "--") == 0 )
+		{
+			// everything after is passed on to the benchmarks
+			for (i++; i < argc; i++)
+			{
+				benchArgs += std::string(" \"") + argv[i] + "\"";
+			}
+		}
+		else
+		{
+			std::cout << "usage: shape_wars_gate [--bench file] [--dir perf] [--baseline revision] [--results file] [--record] [--runs n] [--threshold percent] [--confidence 0.95] [--resamples n] [-- bench options]" << std::endl;
+			return 2;
+		}
+	}
+	std::string rev = revision();
+	std::error_code error;
+	std::filesystem::create_directories(dir, error);
+	// the new results, pooled over every run so slow and fast runs of the whole machine both count
+	Metrics next;
+	if ( !results.empty() )
+	{
+		if ( !readResults(results, next) )
+		{
+			std::cout << "could not read results " << results << std::endl;
+			return 2;
+		}
+	}
+	else
+	{
+		std::string out = dir + "/run.json";
+		for (int r = 0; r < runs; r++)
+		{
+			std::cout << "benchmark run " << r + 1 << " of " << runs << std::endl;
+			std::string cmd = "\"" + bench + "\" --out \"" + out + "\"" + benchArgs;
+			if ( system(cmd.c_str()) != 0 || !readResults(out, next) )
+			{
+				std::cout << "benchmark run failed: " << cmd << std::endl;
+				return 2;
+			}
+		}
+		std::filesystem::remove(out, error);
+	}
+	if ( baseline.empty() )
+	{
+		std::ifstream latest(dir + "/latest");
+		std::getline(latest, baseline);
+	}
+	int regressions = 0;
+	Metrics base;
+	if ( baseline.empty() )
+	{
+		std::cout << "no baseline yet, run with --record to make one" << std::endl;
+	}
+	else if ( !readResults(dir + "/" + baseline + ".json", base) )
+	{
+		std::cout << "could not read baseline " << dir << "/" << baseline << ".json" << std::endl;
+		return 2;
+	}
+	else
+	{
+		Rng rng(1, 0);
+		printf("%s against baseline %s, failing past +%.1f%% at %.0f%% confidence\n", rev.c_str(), baseline.c_str(), threshold, confidence * 100);
+		printf("%-36s %8s %12s %12s %8s %20s\n", "benchmark", "entities", "base ns", "new ns", "change", "interval");
+		for (auto& entry : next)
+		{
+			const Metric& metric = entry.second;
+			auto found = base.find(entry.first);
+			if ( found == base.end() || found->second.samples.empty() || metric.samples.empty() )
+			{
+				printf("%-36s %8zu %12s %12.1f %8s %20s\n", metric.name.c_str(), metric.entities, "-", median(metric.samples), "new", "");
+				continue;
+			}
+			Change change = bootstrap(found->second.samples, metric.samples, resamples, confidence, rng);
+			// only a slowdown we're sure is past the threshold fails, one that might be noise is just marked
+			const char* verdict = "";
+			if ( change.low * 100 > threshold )
+			{
+				verdict = "REGRESSED";
+				regressions++;
+			}
+			else if ( found->second.allocs == 0 && metric.allocs > 0 )
+			{
+				// allocation free was the baseline, any allocation in steady state fails whatever the timings say
+				verdict = "ALLOCATES";
+				regressions++;
+			}
+			else if ( change.high * 100 < -threshold )
+			{
+				verdict = "faster";
+			}
+			else if ( change.change * 100 > threshold )
+			{
+				verdict = "noisy";
+			}
+			char interval[32];
+			snprintf(interval, sizeof(interval), "[%+.1f%%, %+.1f%%]", change.low * 100, change.high * 100);
+			printf("%-36s %8zu %12.1f %12.1f %+7.1f%% %20s %s\n", metric.name.c_str(), metric.entities, median(found->second.samples), median(metric.samples), change.change * 100, interval, verdict);
+		}
+		for (auto& entry : base)
+		{
+			if ( next.find(entry.first) == next.end() )
+			{
+				printf("%-36s %8zu %12.1f %12s %8s\n", entry.second.name.c_str(), entry.second.entities, median(entry.second.samples), "-", "missing");
+			}
+		}
+		if ( regressions )
+		{
+			printf("FAILED: %d of %zu benchmarks regressed past +%.1f%% or started allocating\n", regressions, next.size(), threshold);
+		}
+		else
+		{
+			printf("passed: no benchmark regressed past +%.1f%%\n", threshold);
+		}
+	}
+	if ( record )
+	{
+		std::string file = dir + "/" + rev + ".json";
+		std::ofstream latest(dir + "/latest", std::ios::trunc);
+		if ( !writeBaseline(file, rev, next) || !(latest << rev << std::endl) )
+		{
+			std::cout << "could not record baseline " << file << std::endl;
+			return 2;
+		}
+		std::cout << "recorded baseline " << file << std::endl;
+	}
+
+	return (regressions) ? 1 : 0;
+}
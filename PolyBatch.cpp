@@ -0,0 +1,192 @@
+#include "PolyBatch.h"
+#include "rlgl.h"
+#include <math.h>
+
+namespace
+{
+	// rlgl pads the buffer by up to 4 vertices when a batch switches between lines and triangles
+	const size_t SWITCH_VERTICES = 4;
+
+	// counts vertices into the batch being filled, false when they'd overflow it like rlCheckBufferLimit says
+	bool fits(size_t& queued, size_t vertices)
+	{
+		if ( queued + vertices >= PolyBatch::BATCH_VERTICES )
+		{
+			return false;
+		}
+		queued += vertices;
+
+		return true;
+	}
+}
+
+const std::vector< Vector2 >& PolyBatch::mesh(int sides)
+{
+	if ( sides >= (int)m_meshes.size() )
+	{
+		m_meshes.resize(sides + 1);
+	}
+	std::vector< Vector2 >& unit = m_meshes[sides];
+	if ( unit.empty() )
+	{
+		// same winding and starting angle as raylib's DrawPoly
+		float centralAngle = 0.0f;
+		for (int i = 0; i <= sides; i++)
+		{
+			unit.push_back((Vector2) {sinf(DEG2RAD * centralAngle), cosf(DEG2RAD * centralAngle)});
+			centralAngle += 360.0f / (float)sides;
+		}
+	}
+	
+	return unit;
+}
+
+void PolyBatch::group(const std::vector< ShapeInstance >& shapes)
+{
+	for (auto& group : m_groups)
+	{
+		group.clear();
+	}
+	for (const ShapeInstance& shape : shapes)
+	{
+		int sides = (shape.sides < 3) ? 3 : shape.sides;
+		if ( sides >= (int)m_groups.size() )
+		{
+			m_groups.resize(sides + 1);
+		}
+		m_groups[sides].push_back(&shape);
+	}
+}
+
+size_t PolyBatch::plan(const std::vector< ShapeInstance >& shapes)
+{
+	group(shapes);
+	size_t planned = 0;
+	size_t queued = 0;
+	for (int sides = 3; sides < (int)m_groups.size(); sides++)
+	{
+		if ( m_groups[sides].empty() )
+		{
+			continue;
+		}
+		planned += 2;
+		queued += SWITCH_VERTICES;
+		for (size_t i = 0; i < m_groups[sides].size(); i++)
+		{
+			if ( !fits(queued, 3 * sides) )
+			{
+				planned++;
+				queued = 3 * sides;
+			}
+		}
+		queued += SWITCH_VERTICES;
+		for (const ShapeInstance* shape : m_groups[sides])
+		{
+			if ( shape->outlineW > 0 && !fits(queued, 2 * sides * shape->outlineW) )
+			{
+				planned++;
+				queued = 2 * sides * shape->outlineW;
+			}
+		}
+	}
+
+	return planned;
+}
+
+// the batch being filled is drawn when the next shape's vertices won't fit, by our count or rlgl's
+bool PolyBatch::flush(size_t vertices)
+{
+	if ( fits(m_queued, vertices) && !rlCheckBufferLimit(vertices) )
+	{
+		return false;
+	}
+	m_queued = vertices;
+
+	return true;
+}
+
+void PolyBatch::draw(const std::vector< ShapeInstance >& shapes)
+{
+	batches = 0;
+	m_queued = 0;
+	group(shapes);
+	for (int sides = 3; sides < (int)m_groups.size(); sides++)
+	{
+		if ( m_groups[sides].empty() )
+		{
+			continue;
+		}
+		const std::vector< Vector2 >& unit = mesh(sides);
+		fill(unit, m_groups[sides]);
+		outline(unit, m_groups[sides]);
+	}
+}
+
+void PolyBatch::fill(const std::vector< Vector2 >& unit, const std::vector< const ShapeInstance* >& group)
+{
+	int sides = unit.size() - 1;
+	m_queued += SWITCH_VERTICES;
+	rlBegin(RL_TRIANGLES);
+		for (const ShapeInstance* shape : group)
+		{
+			if ( flush(3 * sides) )
+			{
+				// the batch is full, flush it and keep going in a new one
+				rlEnd();
+				rlglDraw();
+				batches++;
+				rlBegin(RL_TRIANGLES);
+			}
+			float c = cosf(DEG2RAD * shape->rotation);
+			float s = sinf(DEG2RAD * shape->rotation);
+			rlColor4ub(shape->fill.r, shape->fill.g, shape->fill.b, shape->fill.a);
+			for (int i = 0; i < sides; i++)
+			{
+				const Vector2& a = unit[i];
+				const Vector2& b = unit[i + 1];
+				rlVertex2f(shape->pos.x, shape->pos.y);
+				rlVertex2f(shape->pos.x + (a.x * c - a.y * s) * shape->radius, shape->pos.y + (a.x * s + a.y * c) * shape->radius);
+				rlVertex2f(shape->pos.x + (b.x * c - b.y * s) * shape->radius, shape->pos.y + (b.x * s + b.y * c) * shape->radius);
+			}
+		}
+	rlEnd();
+	batches++;
+}
+
+void PolyBatch::outline(const std::vector< Vector2 >& unit, const std::vector< const ShapeInstance* >& group)
+{
+	int sides = unit.size() - 1;
+	m_queued += SWITCH_VERTICES;
+	rlBegin(RL_LINES);
+		for (const ShapeInstance* shape : group)
+		{
+			if ( shape->outlineW <= 0 )
+			{
+				continue;
+			}
+			if ( flush(2 * sides * shape->outlineW) )
+			{
+				rlEnd();
+				rlglDraw();
+				batches++;
+				rlBegin(RL_LINES);
+			}
+			float c = cosf(DEG2RAD * shape->rotation);
+			float s = sinf(DEG2RAD * shape->rotation);
+			rlColor4ub(shape->outline.r, shape->outline.g, shape->outline.b, shape->outline.a);
+			// thick outlines are drawn as nested rings one pixel apart, like the DrawPolyLines loop they replace
+			for (int w = 0; w < shape->outlineW; w++)
+			{
+				float radius = shape->radius + w;
+				for (int i = 0; i < sides; i++)
+				{
+					const Vector2& a = unit[i];
+					const Vector2& b = unit[i + 1];
+					rlVertex2f(shape->pos.x + (a.x * c - a.y * s) * radius, shape->pos.y + (a.x * s + a.y * c) * radius);
+					rlVertex2f(shape->pos.x + (b.x * c - b.y * s) * radius, shape->pos.y + (b.x * s + b.y * c) * radius);
+				}
+			}
+		}
+	rlEnd();
+	batches++;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Snapshot.h"
+#include <vector>
+
+// draws regular polygons grouped by side count. Every group shares one unit mesh and is submitted to rlgl as a
+// triangle batch for the fills and a line batch for the outlines. rlgl's vertex buffer only holds BATCH_VERTICES,
+// and a full one has to be drawn before the group carries on in a new batch: a hexagon's fill is 18 vertices, so a
+// flush every 1.8k hexagons, and its 2 pixel outline 24. Small scenes take two batches per side count, 100k shapes
+// take over a hundred
+class PolyBatch
+{
+private:
+	std::vector< std::vector< Vector2 > > m_meshes; // unit polygon for each side count, sides + 1 points
+	std::vector< std::vector< const ShapeInstance* > > m_groups; // instances for each side count, reused between frames
+	size_t m_queued = 0; // vertices in rlgl's buffer
+	const std::vector< Vector2 >& mesh(int sides);
+	void group(const std::vector< ShapeInstance >& shapes);
+	bool flush(size_t vertices);
+	void fill(const std::vector< Vector2 >& unit, const std::vector< const ShapeInstance* >& group);
+	void outline(const std::vector< Vector2 >& unit, const std::vector< const ShapeInstance* >& group);
+public:
+	static const size_t BATCH_VERTICES = 8192 * 4; // raylib 3.0's MAX_BATCH_ELEMENTS quads of 4 vertices
+	size_t batches = 0; // rlgl batches issued by the last draw
+	void draw(const std::vector< ShapeInstance >& shapes); // expects rlgl's buffer to start empty, as it is after BeginDrawing
+	size_t plan(const std::vector< ShapeInstance >& shapes); // the batches draw() would issue, without touching rlgl
+};
@@ -0,0 +1,150 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <iostream>
+#include <stdio.h>
+
+const char* const profSystemNames[PROF_COUNT] = {
+	"update", "spawner", "move", "collision", "duration", "transform", "background", "snapshot", "render", "frame"
+};
+
+void Profiler::record(ProfSystem system, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end, const AllocCounts& allocs, const PerfSample& counters)
+{
+	uint64_t nanoseconds = std::chrono::duration_cast< std::chrono::nanoseconds >(end - start).count();
+	if ( m_trace )
+	{
+		m_trace->span(profSystemNames[system], start, end);
+	}
+	Window& window = m_windows[system];
+	window.samples[window.head] = (nanoseconds < UINT32_MAX) ? nanoseconds : UINT32_MAX;
+	window.allocs[window.head] = (allocs.allocs < UINT32_MAX) ? allocs.allocs : UINT32_MAX;
+	window.allocBytes[window.head] = (allocs.bytes < UINT32_MAX) ? allocs.bytes : UINT32_MAX;
+	for (int i = 0; i < PERF_COUNT; i++)
+	{
+		window.counters[i][window.head] = (counters.values[i] < UINT32_MAX) ? counters.values[i] : UINT32_MAX;
+	}
+	window.head = (window.head + 1) % PROFILE_WINDOW;
+	window.count = (window.count < PROFILE_WINDOW) ? window.count + 1 : window.count;
+}
+
+void Profiler::recordHeap(size_t peak)
+{
+	m_peaks[m_peakHead] = peak;
+	m_peakHead = (m_peakHead + 1) % PROFILE_WINDOW;
+	m_peakCount = (m_peakCount < PROFILE_WINDOW) ? m_peakCount + 1 : m_peakCount;
+}
+
+void Profiler::setTrace(TraceBuffer* trace)
+{
+	m_trace = trace;
+}
+
+ProfStats Profiler::stats(ProfSystem system) const
+{
+	const Window& window = m_windows[system];
+	ProfStats stats;
+	stats.samples = window.count;
+	if ( window.count == 0 )
+	{
+		return stats;
+	}
+	// the ring isn't in time order once it's wrapped, which doesn't matter for any of these
+	uint64_t allocs = 0;
+	uint64_t allocBytes = 0;
+	for (size_t i = 0; i < window.count; i++)
+	{
+		allocs += window.allocs[i];
+		allocBytes += window.allocBytes[i];
+	}
+	stats.allocs = allocs / (double)window.count;
+	stats.allocBytes = allocBytes / (double)window.count;
+	uint64_t counters[PERF_COUNT] = {};
+	for (int c = 0; c < PERF_COUNT; c++)
+	{
+		for (size_t i = 0; i < window.count; i++)
+		{
+			counters[c] += window.counters[c][i];
+		}
+	}
+	if ( counters[PERF_CYCLES] && counters[PERF_INSTRUCTIONS] )
+	{
+		double kilo = counters[PERF_INSTRUCTIONS] / 1e3;
+		stats.ipc = counters[PERF_INSTRUCTIONS] / (double)counters[PERF_CYCLES];
+		stats.l1Mpki = counters[PERF_L1D_MISSES] / kilo;
+		stats.llcMpki = counters[PERF_LLC_MISSES] / kilo;
+		stats.branchMpki = counters[PERF_BRANCH_MISSES] / kilo;
+	}
+	uint32_t sorted[PROFILE_WINDOW];
+	std::copy(window.samples, window.samples + window.count, sorted);
+	std::sort(sorted, sorted + window.count);
+	uint64_t total = 0;
+	for (size_t i = 0; i < window.count; i++)
+	{
+		total += sorted[i];
+	}
+	stats.average = total / (double)window.count / 1e3;
+	stats.p50 = sorted[window.count / 2] / 1e3;
+	stats.p99 = sorted[(window.count * 99) / 100] / 1e3;
+	stats.max = sorted[window.count - 1] / 1e3;
+
+	return stats;
+}
+
+void Profiler::update()
+{
+	// allocations and hardware counters add columns when they're being kept
+	bool counters = perfCountersEnabled();
+	m_lines.resize(PROF_COUNT + 1);
+	m_lines[0] = "system       avg    p50    p99    max us";
+#if defined(SW_ALLOCS)
+	m_lines[0] += "  allocs     KB";
+#endif
+	if ( counters )
+	{
+		m_lines[0] += "   IPC  L1/ki LLC/ki  br/ki";
+	}
+	char line[96];
+	for (int s = 0; s < PROF_COUNT; s++)
+	{
+		ProfStats st = stats((ProfSystem)s);
+		snprintf(line, sizeof(line), "%-10s %6.1f %6.1f %6.1f %6.1f", profSystemNames[s], st.average, st.p50, st.p99, st.max);
+		m_lines[s + 1] = line;
+#if defined(SW_ALLOCS)
+		snprintf(line, sizeof(line), " %7.1f %6.1f", st.allocs, st.allocBytes / 1024);
+		m_lines[s + 1] += line;
+#endif
+		if ( counters )
+		{
+			snprintf(line, sizeof(line), " %5.2f %6.2f %6.2f %6.2f", st.ipc, st.l1Mpki, st.llcMpki, st.branchMpki);
+			m_lines[s + 1] += line;
+		}
+	}
+#if defined(SW_ALLOCS)
+	// live heap at its highest in each frame, the working set the allocations above add up to
+	if ( m_peakCount )
+	{
+		size_t sorted[PROFILE_WINDOW];
+		std::copy(m_peaks, m_peaks + m_peakCount, sorted);
+		std::sort(sorted, sorted + m_peakCount);
+		snprintf(line, sizeof(line), "heap peak p50 %.0f KB, max %.0f KB, live %.0f KB", sorted[m_peakCount / 2] / 1024.0, sorted[m_peakCount - 1] / 1024.0, liveBytes() / 1024.0);
+		m_lines.push_back(line);
+	}
+#endif
+}
+
+void Profiler::draw(const Font& font, float size, const Vector2& pos, const Color& colour) const
+{
+	for (size_t i = 0; i < m_lines.size(); i++)
+	{
+		DrawTextEx(font, m_lines[i].c_str(), (Vector2) {pos.x, pos.y + i * size}, size, 1, colour);
+	}
+}
+
+void Profiler::report()
+{
+	update();
+	std::cout << "profile over the last " << PROFILE_WINDOW << " samples of each system" << std::endl;
+	for (const std::string& line : m_lines)
+	{
+		std::cout << line << std::endl;
+	}
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "raylib.h"
+#include "Trace.h"
+#include "Alloc.h"
+#include "PerfCounters.h"
+#include <chrono>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+// the systems a frame's time is split between
+enum ProfSystem
+{
+	PROF_UPDATE, // EntityManager::update
+	PROF_SPAWNER,
+	PROF_MOVE,
+	PROF_COLLISION,
+	PROF_DURATION,
+	PROF_TRANSFORM,
+	PROF_BACKGROUND, // Background::step, spawner and move
+	PROF_SNAPSHOT,
+	PROF_RENDER,
+	PROF_FRAME, // the whole of Game::run
+	PROF_COUNT
+};
+
+const size_t PROFILE_WINDOW = 256; // samples each system's statistics are taken over
+
+extern const char* const profSystemNames[PROF_COUNT];
+
+struct ProfStats
+{
+	double average = 0; // microseconds
+	double p50 = 0;
+	double p99 = 0;
+	double max = 0;
+	size_t samples = 0;
+	double allocs = 0; // average per run, ALLOCS=TRUE only
+	double allocBytes = 0;
+	double ipc = 0; // instructions per cycle, with perfCountersEnable() only
+	double l1Mpki = 0; // misses per thousand instructions
+	double llcMpki = 0;
+	double branchMpki = 0;
+};
+
+// rolling window of how long each system took. Each system must only be timed from one thread, and stats() or
+// update() only called while none of them are running
+class Profiler
+{
+private:
+	struct Window
+	{
+		uint32_t samples[PROFILE_WINDOW]; // nanoseconds
+		uint32_t allocs[PROFILE_WINDOW];
+		uint32_t allocBytes[PROFILE_WINDOW];
+		uint32_t counters[PERF_COUNT][PROFILE_WINDOW];
+		size_t head = 0;
+		size_t count = 0;
+	};
+	Window m_windows[PROF_COUNT];
+	size_t m_peaks[PROFILE_WINDOW]; // highest live heap bytes in each frame
+	size_t m_peakHead = 0;
+	size_t m_peakCount = 0;
+	std::vector< std::string > m_lines;
+	TraceBuffer* m_trace = nullptr;
+public:
+	void record(ProfSystem system, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end, const AllocCounts& allocs = AllocCounts(), const PerfSample& counters = PerfSample());
+	void recordHeap(size_t peak); // once a frame, from allocPeak()
+	void setTrace(TraceBuffer* trace); // every timed scope also goes in the trace
+	ProfStats stats(ProfSystem system) const;
+	void update(); // formats the overlay, once per frame
+	void draw(const Font& font, float size, const Vector2& pos, const Color& colour) const;
+	void report(); // the same table to stdout
+};
+
+// times the enclosing block
+class ProfileScope
+{
+private:
+	Profiler& m_profiler;
+	ProfSystem m_system;
+	AllocCounts m_allocs; // this thread's, so each scope gets what was allocated inside it, nested scopes included
+	PerfSample m_counters; // likewise, read outside the timed part since it's a syscall
+	std::chrono::steady_clock::time_point m_start;
+	// a frame's systems run on the simulation thread while its scope is on the main one, so it counts every thread's
+	static AllocCounts allocs(ProfSystem system)
+	{
+		return (system == PROF_FRAME) ? processAllocs() : threadAllocs();
+	}
+public:
+	ProfileScope(Profiler& profiler, ProfSystem system)
+		: m_profiler(profiler), m_system(system), m_allocs(allocs(system)), m_counters(perfRead()), m_start(std::chrono::steady_clock::now()) {}
+	~ProfileScope()
+	{
+		auto end = std::chrono::steady_clock::now();
+		PerfSample counters = perfRead();
+		for (int i = 0; i < PERF_COUNT; i++)
+		{
+			counters.values[i] -= m_counters.values[i];
+		}
+		AllocCounts now = allocs(m_system);
+		now.allocs -= m_allocs.allocs;
+		now.bytes -= m_allocs.bytes;
+		m_profiler.record(m_system, m_start, end, now, counters);
+	}
+};
+
+// built with PROFILE=TRUE (SW_PROFILE) the scopes time into the enclosing Game's m_profiler, otherwise they're nothing
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+#if defined(SW_PROFILE)
+	#define PROFILE_SCOPE(system) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(m_profiler, system)
+#else
+	#define PROFILE_SCOPE(system)
+#endif
@@ -0,0 +1,133 @@
+#include "Random.h"
+
+namespace
+{
+	const uint64_t PCG_MULTIPLIER = 6364136223846793005ULL;
+	const int LANES = 4; // states a bulk draw advances at once
+	const size_t BATCH = 64; // raw numbers a bulk draw makes before mapping them to its range
+	
+	// PCG's output function, a permutation of the state before it was advanced
+	inline uint32_t permute(uint64_t old)
+	{
+		uint32_t xorshifted = ((old >> 18u) ^ old) >> 27u;
+		uint32_t rot = old >> 59u;
+		
+		return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+	}
+}
+
+Rng::Rng(uint64_t seed, uint64_t stream)
+{
+	this->seed(seed, stream);
+}
+
+void Rng::seed(uint64_t seed, uint64_t stream)
+{
+	m_state = 0;
+	m_inc = (stream << 1u) | 1u;
+	next();
+	m_state += seed;
+	next();
+}
+
+uint32_t Rng::next()
+{
+	uint64_t old = m_state;
+	m_state = old * PCG_MULTIPLIER + m_inc;
+	
+	return permute(old);
+}
+
+// one step at a time every number waits on the multiply before it. Jumping each lane straight to its own state
+// (state k steps on is mul^k * state + inc * (1 + mul + ... + mul^(k-1))) makes a round's LANES states independent
+void Rng::next(uint32_t* out, size_t count)
+{
+	uint64_t mul[LANES + 1];
+	uint64_t add[LANES + 1];
+	mul[0] = 1;
+	add[0] = 0;
+	for (int k = 1; k <= LANES; k++)
+	{
+		mul[k] = mul[k - 1] * PCG_MULTIPLIER;
+		add[k] = add[k - 1] * PCG_MULTIPLIER + m_inc;
+	}
+	size_t i = 0;
+	for (; i + LANES <= count; i += LANES)
+	{
+		for (int k = 0; k < LANES; k++)
+		{
+			out[i + k] = permute(mul[k] * m_state + add[k]);
+		}
+		m_state = mul[LANES] * m_state + add[LANES];
+	}
+	for (; i < count; i++)
+	{
+		out[i] = next();
+	}
+}
+
+RngState Rng::getState() const
+{
+	return (RngState) {m_state, m_inc};
+}
+
+void Rng::setState(const RngState& state)
+{
+	m_state = state.state;
+	m_inc = state.inc;
+}
+
+int Rng::range(int min, int max)
+{
+	if ( min > max )
+	{
+		int tmp = max;
+		max = min;
+		min = tmp;
+	}
+	uint64_t span = (uint64_t)((int64_t)max - min) + 1;
+	
+	return min + (int)(((uint64_t)next() * span) >> 32);
+}
+
+float Rng::uniform(float min, float max)
+{
+	// top 24 bits fill a float's mantissa exactly
+	return min + (next() >> 8) * (1.0f / 16777216.0f) * (max - min);
+}
+
+// raw numbers come out a batch at a time, then get mapped to the range in a loop simple enough to vectorise
+void Rng::range(int* out, size_t count, int min, int max)
+{
+	if ( min > max )
+	{
+		int tmp = max;
+		max = min;
+		min = tmp;
+	}
+	uint64_t span = (uint64_t)((int64_t)max - min) + 1;
+	uint32_t raw[BATCH];
+	for (size_t done = 0; done < count; done += BATCH)
+	{
+		size_t size = (count - done < BATCH) ? count - done : BATCH;
+		next(raw, size);
+		for (size_t i = 0; i < size; i++)
+		{
+			out[done + i] = min + (int)(((uint64_t)raw[i] * span) >> 32);
+		}
+	}
+}
+
+void Rng::uniform(float* out, size_t count, float min, float max)
+{
+	uint32_t raw[BATCH];
+	for (size_t done = 0; done < count; done += BATCH)
+	{
+		size_t size = (count - done < BATCH) ? count - done : BATCH;
+		next(raw, size);
+		for (size_t i = 0; i < size; i++)
+		{
+			out[done + i] = min + (raw[i] >> 8) * (1.0f / 16777216.0f) * (max - min);
+		}
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+struct RngState
+{
+	uint64_t state = 0;
+	uint64_t inc = 1;
+};
+
+// PCG32 random number generator (pcg-random.org). Small, fast and fully determined by its seed and stream,
+// so every system can own an independent stream and identical seeds replay identical games
+class Rng
+{
+private:
+	uint64_t m_state = 0;
+	uint64_t m_inc = 1;
+public:
+	Rng(uint64_t seed = 0, uint64_t stream = 0);
+	void seed(uint64_t seed, uint64_t stream);
+	uint32_t next();
+	void next(uint32_t* out, size_t count); // the same numbers as count calls to next(), several steps at a time
+	RngState getState() const;
+	void setState(const RngState& state);
+	int range(int min, int max); // inclusive on both ends, like raylib's GetRandomValue
+	float uniform(float min, float max); // [min, max)
+	// bulk draws for batch spawning, the same values as calling the single versions in a loop
+	void range(int* out, size_t count, int min, int max);
+	void uniform(float* out, size_t count, float min, float max);
+};
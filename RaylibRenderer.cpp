@@ -0,0 +1,32 @@
+#include "RaylibRenderer.h"
+
+void RaylibRenderer::setFont(const Font& font, float size, const Color& colour)
+{
+	m_font = &font;
+	m_fontSize = size;
+	m_fontColour = colour;
+}
+
+void RaylibRenderer::draw(const RenderSnapshot& frame)
+{
+	ClearBackground(frame.background);
+	m_polyBatch.draw(frame.shapes);
+	if ( !m_font )
+	{
+		return;
+	}
+	// HUD text is only re-laid out when the number changes
+	HudLine lines[3];
+	hudLines(frame, m_fontSize, GetScreenWidth(), lines);
+	for (int i = 0; i < 3; i++)
+	{
+		m_hud[i].setValue(*m_font, lines[i].prefix, lines[i].value, m_fontSize, 2);
+		m_hud[i].draw(*m_font, lines[i].pos, m_fontColour);
+	}
+	for (const LabelInstance& label : frame.labels)
+	{
+		CachedText& text = m_labelText[label.text];
+		text.setText(*m_font, label.text, label.size, 2);
+		text.draw(*m_font, label.pos, label.colour);
+	}
+}
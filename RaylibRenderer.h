@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Renderer.h"
+#include "PolyBatch.h"
+#include "TextCache.h"
+#include <map>
+
+// draws to the raylib window. Must be called between BeginDrawing and EndDrawing on the thread that owns the window
+class RaylibRenderer : public Renderer
+{
+private:
+	PolyBatch m_polyBatch;
+	CachedText m_hud[3];
+	std::map< const char*, CachedText > m_labelText; // label strings are owned by Game and never change
+	const Font* m_font = nullptr;
+	float m_fontSize = 20;
+	Color m_fontColour = WHITE;
+public:
+	void setFont(const Font& font, float size, const Color& colour);
+	void draw(const RenderSnapshot& frame) override;
+};
@@ -0,0 +1,8 @@
+#include "Renderer.h"
+
+void hudLines(const RenderSnapshot& frame, float fontSize, float screenWidth, HudLine lines[3])
+{
+	lines[0] = (HudLine) {"SCORE: ", frame.score, (Vector2) {8, fontSize + 2}};
+	lines[1] = (HudLine) {"HIGH SCORE: ", frame.highScore, (Vector2) {8, fontSize * 2 + 2}};
+	lines[2] = (HudLine) {"TIME: ", frame.seconds, (Vector2) {screenWidth - 8 * fontSize, fontSize + 2}};
+}
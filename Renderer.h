@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Snapshot.h"
+
+struct HudLine
+{
+	const char* prefix;
+	int value;
+	Vector2 pos;
+};
+
+// draws a RenderSnapshot to some target: the window, an in-memory image...
+class Renderer
+{
+public:
+	virtual ~Renderer() {}
+	virtual void draw(const RenderSnapshot& frame) = 0;
+};
+
+// the SCORE, HIGH SCORE and TIME lines. Shared so every renderer lays the HUD out the same way
+void hudLines(const RenderSnapshot& frame, float fontSize, float screenWidth, HudLine lines[3]);
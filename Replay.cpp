@@ -0,0 +1,171 @@
+#include "Replay.h"
+#include <iterator>
+
+namespace
+{
+	const uint32_t REPLAY_MAGIC = 0x50525753; // "SWRP"
+	const uint16_t REPLAY_VERSION = 1;
+}
+
+bool InputFrame::held(uint8_t button) const
+{
+	return buttons & button;
+}
+
+bool InputFrame::operator==(const InputFrame& other) const
+{
+	return buttons == other.buttons && mouseX == other.mouseX && mouseY == other.mouseY;
+}
+
+bool InputFrame::operator!=(const InputFrame& other) const
+{
+	return !(*this == other);
+}
+
+InputRecorder::~InputRecorder()
+{
+	close();
+}
+
+bool InputRecorder::open(const char* file, const ReplayHeader& header)
+{
+	m_out.open(file, std::ios::binary | std::ios::trunc);
+	if ( !m_out )
+	{
+		return false;
+	}
+	m_buffer.clear();
+	m_buffer.u32(REPLAY_MAGIC);
+	m_buffer.u16(REPLAY_VERSION);
+	m_buffer.u64(header.seed);
+	m_buffer.u16(header.fps);
+	m_buffer.u16(header.width);
+	m_buffer.u16(header.height);
+	m_buffer.u8(header.paused);
+	m_count = 0;
+	m_ticks = 0;
+	flush();
+	
+	return true;
+}
+
+void InputRecorder::writeRun()
+{
+	// buttons, repeat count, then the mouse only if it matters
+	m_buffer.u8(m_run.buttons);
+	m_buffer.varint(m_count);
+	if ( m_run.held(INPUT_SHOOT) )
+	{
+		m_buffer.i16(m_run.mouseX);
+		m_buffer.i16(m_run.mouseY);
+	}
+	m_count = 0;
+}
+
+void InputRecorder::push(const InputFrame& frame)
+{
+	if ( !m_out.is_open() )
+	{
+		return;
+	}
+	if ( m_count && frame != m_run )
+	{
+		writeRun();
+	}
+	m_run = frame;
+	m_count++;
+	m_ticks++;
+}
+
+void InputRecorder::flush()
+{
+	if ( !m_out.is_open() )
+	{
+		return;
+	}
+	m_out.write((const char*)m_buffer.data().data(), m_buffer.size());
+	m_out.flush();
+	m_buffer.clear();
+}
+
+void InputRecorder::close()
+{
+	if ( !m_out.is_open() )
+	{
+		return;
+	}
+	if ( m_count )
+	{
+		writeRun();
+	}
+	flush();
+	m_out.close();
+}
+
+size_t InputRecorder::ticks() const
+{
+	return m_ticks;
+}
+
+bool InputPlayback::open(const char* file)
+{
+	std::ifstream in(file, std::ios::binary);
+	if ( !in )
+	{
+		return false;
+	}
+	m_data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+	ByteReader reader(m_data);
+	if ( reader.u32() != REPLAY_MAGIC || reader.u16() != REPLAY_VERSION )
+	{
+		return false;
+	}
+	m_header.seed = reader.u64();
+	m_header.fps = reader.u16();
+	m_header.width = reader.u16();
+	m_header.height = reader.u16();
+	m_header.paused = reader.u8();
+	m_pos = reader.pos();
+	m_remaining = 0;
+	m_ticks = 0;
+	
+	return reader.ok();
+}
+
+bool InputPlayback::next(InputFrame& frame)
+{
+	if ( m_remaining == 0 )
+	{
+		ByteReader reader(m_data.data() + m_pos, m_data.size() - m_pos);
+		InputFrame run;
+		run.buttons = reader.u8();
+		m_remaining = reader.varint();
+		if ( run.held(INPUT_SHOOT) )
+		{
+			run.mouseX = reader.i16();
+			run.mouseY = reader.i16();
+		}
+		if ( !reader.ok() || m_remaining == 0 )
+		{
+			m_remaining = 0;
+			return false;
+		}
+		m_pos += reader.pos();
+		m_run = run;
+	}
+	frame = m_run;
+	m_remaining--;
+	m_ticks++;
+	
+	return true;
+}
+
+const ReplayHeader& InputPlayback::header() const
+{
+	return m_header;
+}
+
+size_t InputPlayback::ticks() const
+{
+	return m_ticks;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "Serialize.h"
+#include <fstream>
+
+enum InputButton
+{
+	INPUT_UP = 1 << 0,
+	INPUT_DOWN = 1 << 1,
+	INPUT_LEFT = 1 << 2,
+	INPUT_RIGHT = 1 << 3,
+	INPUT_SHOOT = 1 << 4,
+	INPUT_SPECIAL = 1 << 5,
+	INPUT_DASH = 1 << 6,
+	INPUT_PAUSE = 1 << 7 // P or the play button this frame
+};
+
+// everything the simulation reads from the player in one tick
+struct InputFrame
+{
+	uint8_t buttons = 0;
+	int16_t mouseX = 0; // screen pixels, only kept while shooting since nothing else reads it
+	int16_t mouseY = 0;
+	
+	bool held(uint8_t button) const;
+	bool operator==(const InputFrame& other) const;
+	bool operator!=(const InputFrame& other) const;
+};
+
+struct ReplayHeader
+{
+	uint64_t seed = 0;
+	uint16_t fps = 60;
+	uint16_t width = 0;
+	uint16_t height = 0;
+	bool paused = true; // windowed games start on the menu, headless ones don't
+};
+
+// writes one InputFrame per tick to disk. Identical consecutive frames are stored once with a repeat count
+class InputRecorder
+{
+private:
+	std::ofstream m_out;
+	ByteWriter m_buffer;
+	InputFrame m_run;
+	uint64_t m_count = 0; // ticks in the current run
+	size_t m_ticks = 0;
+	void writeRun();
+public:
+	~InputRecorder();
+	bool open(const char* file, const ReplayHeader& header);
+	void push(const InputFrame& frame);
+	void flush(); // pushes everything recorded so far to disk, so a crash loses at most the current run
+	void close();
+	size_t ticks() const;
+};
+
+// reads a recording back one tick at a time
+class InputPlayback
+{
+private:
+	std::vector< uint8_t > m_data;
+	size_t m_pos = 0;
+	InputFrame m_run;
+	uint64_t m_remaining = 0;
+	size_t m_ticks = 0;
+	ReplayHeader m_header;
+public:
+	bool open(const char* file);
+	bool next(InputFrame& frame);
+	const ReplayHeader& header() const;
+	size_t ticks() const;
+};
@@ -0,0 +1,511 @@
+#include "SaveState.h"
+#include <string.h>
+#include <stddef.h>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+	#error "save states copy component words as they are in memory, which assumes a little endian host"
+#endif
+
+namespace
+{
+	const uint32_t STATE_MAGIC = 0x53535753; // "SWSS"
+	const uint16_t STATE_VERSION = 2; // 2 added the second player
+	
+	// where each component's words live inside EntityState, in ComponentBit order
+	const size_t COMPONENT_OFFSET[COMPONENT_COUNT] = {
+		offsetof(EntityState, transform),
+		offsetof(EntityState, shape),
+		offsetof(EntityState, collision),
+		offsetof(EntityState, input),
+		offsetof(EntityState, score),
+		offsetof(EntityState, duration),
+		offsetof(EntityState, dash),
+		offsetof(EntityState, label)
+	};
+	const size_t COMPONENT_SIZE[COMPONENT_COUNT] = {
+		sizeof(TransformState) / 4,
+		sizeof(ShapeState) / 4,
+		1,
+		1,
+		1,
+		sizeof(DurationState) / 4,
+		sizeof(DashState) / 4,
+		sizeof(LabelState) / 4
+	};
+	static_assert(sizeof(TransformState) == 20 && sizeof(ShapeState) == 20 && sizeof(DurationState) == 8 && sizeof(DashState) == 20 && sizeof(LabelState) == 12, "copyWords handles blocks of 1, 2, 3 and 5 words");
+	static_assert(sizeof(TransformState) % 4 == 0 && sizeof(ShapeState) % 4 == 0 && sizeof(DurationState) % 4 == 0 && sizeof(DashState) % 4 == 0 && sizeof(LabelState) % 4 == 0, "component blocks must be whole words");
+	
+	uint8_t tagIndex(std::vector< std::string >& tags, const std::string& tag)
+	{
+		for (size_t i = 0; i < tags.size(); i++)
+		{
+			if ( tags[i] == tag )
+			{
+				return i;
+			}
+		}
+		tags.push_back(tag);
+		
+		return tags.size() - 1;
+	}
+	
+	int32_t labelIndex(const std::vector< const char* >& labels, const char* text)
+	{
+		for (size_t i = 0; i < labels.size(); i++)
+		{
+			if ( labels[i] == text || strcmp(labels[i], text) == 0 )
+			{
+				return i;
+			}
+		}
+		
+		return -1;
+	}
+	
+	template < class T >
+	void assign(std::shared_ptr< T >& component, const T& value)
+	{
+		if ( component )
+		{
+			*component = value;
+		}
+		else
+		{
+			component = std::make_shared< T >(value);
+		}
+	}
+	
+	void captureEntity(const Entity& e, EntityState& s, const std::vector< const char* >& labels)
+	{
+		// records get reused between captures, absent blocks are zeroed so equal entities always compare equal
+		s = EntityState();
+		if ( e.cTransform )
+		{
+			s.components |= HAS_TRANSFORM;
+			s.transform = (TransformState) {e.cTransform->pos, e.cTransform->velocity, e.cTransform->rotation};
+		}
+		if ( e.cShape )
+		{
+			s.components |= HAS_SHAPE;
+			s.shape = (ShapeState) {e.cShape->sides, e.cShape->radius, e.cShape->colour, e.cShape->outlineC, e.cShape->outlineW};
+		}
+		if ( e.cCollision )
+		{
+			s.components |= HAS_COLLISION;
+			s.collision = e.cCollision->radius;
+		}
+		if ( e.cInput )
+		{
+			s.components |= HAS_INPUT;
+			const CInput& in = *e.cInput;
+			s.input = in.up | in.left << 1 | in.right << 2 | in.down << 3 | in.shoot << 4 | in.special << 5 | in.dash << 6;
+		}
+		if ( e.cScore )
+		{
+			s.components |= HAS_SCORE;
+			s.score = e.cScore->val;
+		}
+		if ( e.cDuration )
+		{
+			s.components |= HAS_DURATION;
+			s.duration = (DurationState) {e.cDuration->frames, e.cDuration->frameCreated};
+		}
+		if ( e.cDash )
+		{
+			s.components |= HAS_DASH;
+			s.dash = (DashState) {e.cDash->frames, e.cDash->frameStarted, e.cDash->delay, e.cDash->speedMod, e.cDash->active};
+		}
+		if ( e.cLabel )
+		{
+			s.components |= HAS_LABEL;
+			s.label = (LabelState) {labelIndex(labels, e.cLabel->text), e.cLabel->size, e.cLabel->colour};
+		}
+	}
+	
+	void applyEntity(Entity& e, const EntityState& s, const std::vector< const char* >& labels)
+	{
+		if ( s.components & HAS_TRANSFORM )
+		{
+			assign(e.cTransform, CTransform(s.transform.pos, s.transform.velocity, s.transform.rotation));
+		}
+		else
+		{
+			e.cTransform.reset();
+		}
+		if ( s.components & HAS_SHAPE )
+		{
+			assign(e.cShape, CShape(s.shape.sides, s.shape.radius, s.shape.colour, s.shape.outlineC, s.shape.outlineW));
+		}
+		else
+		{
+			e.cShape.reset();
+		}
+		if ( s.components & HAS_COLLISION )
+		{
+			assign(e.cCollision, CCollision(s.collision));
+		}
+		else
+		{
+			e.cCollision.reset();
+		}
+		if ( s.components & HAS_INPUT )
+		{
+			CInput in;
+			in.up = s.input & 1;
+			in.left = s.input & 2;
+			in.right = s.input & 4;
+			in.down = s.input & 8;
+			in.shoot = s.input & 16;
+			in.special = s.input & 32;
+			in.dash = s.input & 64;
+			assign(e.cInput, in);
+		}
+		else
+		{
+			e.cInput.reset();
+		}
+		if ( s.components & HAS_SCORE )
+		{
+			assign(e.cScore, CScore(s.score));
+		}
+		else
+		{
+			e.cScore.reset();
+		}
+		if ( s.components & HAS_DURATION )
+		{
+			assign(e.cDuration, CDuration(s.duration.lifespan, s.duration.frameCreated));
+		}
+		else
+		{
+			e.cDuration.reset();
+		}
+		if ( s.components & HAS_DASH )
+		{
+			assign(e.cDash, CDash(s.dash.frames, s.dash.frameStarted, s.dash.delay, s.dash.speedMod, s.dash.active));
+		}
+		else
+		{
+			e.cDash.reset();
+		}
+		if ( s.components & HAS_LABEL )
+		{
+			const char* text = (s.label.label >= 0 && s.label.label < (int32_t)labels.size()) ? labels[s.label.label] : "";
+			assign(e.cLabel, CLabel(text, s.label.size, s.label.colour));
+		}
+		else
+		{
+			e.cLabel.reset();
+		}
+	}
+	
+	void writeInt(ByteWriter& out, int32_t v)
+	{
+		// zigzag so small negative numbers stay small
+		out.varint(((uint32_t)v << 1) ^ (uint32_t)(v >> 31));
+	}
+	
+	int32_t readInt(ByteReader& in)
+	{
+		uint32_t v = in.varint();
+		
+		return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+	}
+	
+	void writeColour(ByteWriter& out, const Color& c)
+	{
+		out.bytes(&c, 4);
+	}
+	
+	Color readColour(ByteReader& in)
+	{
+		Color c = {0, 0, 0, 0};
+		in.bytes(&c, 4);
+		
+		return c;
+	}
+	
+	void writeRng(ByteWriter& out, const RngState& rng)
+	{
+		out.u64(rng.state);
+		out.u64(rng.inc);
+	}
+	
+	RngState readRng(ByteReader& in)
+	{
+		RngState rng;
+		rng.state = in.u64();
+		rng.inc = in.u64();
+		
+		return rng;
+	}
+	
+	// the largest an entity's record can be: a five byte id, tag, flags, component bits and every component
+	const size_t RECORD_MAX = 5 + 3 + sizeof(EntityState);
+	
+	// every component block is 1, 2, 3 or 5 words. Each branch is a fixed size copy, which compiles down to a few moves
+	// where a memcpy of a size only known at run time would be a call per component
+	void copyWords(void* dst, const void* src, size_t words)
+	{
+		if ( words == 5 )
+		{
+			memcpy(dst, src, 20);
+		}
+		else if ( words == 3 )
+		{
+			memcpy(dst, src, 12);
+		}
+		else if ( words == 2 )
+		{
+			memcpy(dst, src, 8);
+		}
+		else
+		{
+			memcpy(dst, src, 4);
+		}
+	}
+	
+	void writeEntity(ByteWriter& out, const EntityState& s)
+	{
+		// built up here and handed to the writer in one go rather than a call per field
+		uint8_t record[RECORD_MAX];
+		size_t size = 0;
+		uint32_t id = s.id;
+		while ( id >= 0x80 )
+		{
+			record[size++] = (id & 0x7f) | 0x80;
+			id >>= 7;
+		}
+		record[size++] = id;
+		record[size++] = s.tag;
+		record[size++] = s.flags;
+		record[size++] = s.components;
+		// component blocks go out as raw little endian words
+		for (int c = 0; c < COMPONENT_COUNT; c++)
+		{
+			if ( s.components & (1 << c) )
+			{
+				copyWords(record + size, componentWords(s, c), COMPONENT_SIZE[c]);
+				size += COMPONENT_SIZE[c] * 4;
+			}
+		}
+		out.bytes(record, size);
+	}
+	
+	void readEntity(ByteReader& in, EntityState& s)
+	{
+		s = EntityState();
+		s.id = in.varint();
+		uint8_t header[3] = {0, 0, 0};
+		in.bytes(header, 3);
+		s.tag = header[0];
+		s.flags = header[1];
+		s.components = header[2];
+		// the component bits give the size of the rest, so it comes out of the reader in one piece
+		uint8_t record[sizeof(EntityState)];
+		size_t size = 0;
+		for (int c = 0; c < COMPONENT_COUNT; c++)
+		{
+			size += (s.components & (1 << c)) ? COMPONENT_SIZE[c] * 4 : 0;
+		}
+		if ( !in.bytes(record, size) )
+		{
+			return;
+		}
+		size_t pos = 0;
+		for (int c = 0; c < COMPONENT_COUNT; c++)
+		{
+			if ( s.components & (1 << c) )
+			{
+				copyWords(componentWords(s, c), record + pos, COMPONENT_SIZE[c]);
+				pos += COMPONENT_SIZE[c] * 4;
+			}
+		}
+	}
+	
+	void writeList(ByteWriter& out, const EntityListState& list)
+	{
+		out.varint(list.total);
+		out.varint(list.entities.size());
+		for (const EntityState& s : list.entities)
+		{
+			writeEntity(out, s);
+		}
+	}
+	
+	bool readList(ByteReader& in, EntityListState& list, size_t tags)
+	{
+		list.total = in.varint();
+		size_t count = in.varint();
+		// every entity takes at least 4 bytes, don't trust a count the buffer can't hold
+		if ( count > in.remaining() / 4 )
+		{
+			return false;
+		}
+		list.entities.resize(count);
+		for (EntityState& s : list.entities)
+		{
+			readEntity(in, s);
+			if ( s.tag >= tags )
+			{
+				return false;
+			}
+		}
+		
+		return in.ok();
+	}
+}
+
+uint32_t* componentWords(EntityState& state, int component)
+{
+	return (uint32_t*)((uint8_t*)&state + COMPONENT_OFFSET[component]);
+}
+
+const uint32_t* componentWords(const EntityState& state, int component)
+{
+	return (const uint32_t*)((const uint8_t*)&state + COMPONENT_OFFSET[component]);
+}
+
+size_t componentSize(int component)
+{
+	return COMPONENT_SIZE[component];
+}
+
+void captureEntities(EntityManager& manager, EntityListState& out, std::vector< std::string >& tags, const std::vector< const char* >& labels)
+{
+	EntityVec& entities = manager.getEntities();
+	EntityVec& pending = manager.getPending();
+	out.total = manager.getTotal();
+	out.entities.resize(entities.size() + pending.size());
+	size_t i = 0;
+	for (const auto& e : entities)
+	{
+		EntityState& s = out.entities[i++];
+		captureEntity(*e, s, labels);
+		s.id = e->id();
+		s.tag = tagIndex(tags, e->tag());
+		s.flags = (e->isActive()) ? ENTITY_ACTIVE : 0;
+	}
+	for (const auto& e : pending)
+	{
+		EntityState& s = out.entities[i++];
+		captureEntity(*e, s, labels);
+		s.id = e->id();
+		s.tag = tagIndex(tags, e->tag());
+		s.flags = ENTITY_PENDING | ((e->isActive()) ? ENTITY_ACTIVE : 0);
+	}
+}
+
+void restoreEntities(EntityManager& manager, const EntityListState& in, const std::vector< std::string >& tags, const std::vector< const char* >& labels)
+{
+	EntityVec& liveEntities = manager.getEntities();
+	EntityVec& livePending = manager.getPending();
+	size_t liveCount = liveEntities.size() + livePending.size();
+	auto live = [&](size_t i) -> std::shared_ptr< Entity >& { return (i < liveEntities.size()) ? liveEntities[i] : livePending[i - liveEntities.size()]; };
+	EntityVec entities;
+	EntityVec pending;
+	std::vector< uint8_t > entityTags;
+	entities.reserve(in.entities.size());
+	entityTags.reserve(in.entities.size());
+	// both lists are in id order, so live entities can be matched up in one pass and reused
+	size_t l = 0;
+	size_t kept = 0;
+	for (const EntityState& s : in.entities)
+	{
+		const std::string& tag = tags[s.tag];
+		while ( l < liveCount && live(l)->id() < s.id )
+		{
+			l++;
+		}
+		std::shared_ptr< Entity > e;
+		if ( l < liveCount && live(l)->id() == s.id && live(l)->tag() == tag )
+		{
+			kept += ( l < liveEntities.size() && !(s.flags & ENTITY_PENDING) ) ? 1 : 0;
+			e = std::move(live(l++)); // the live lists are replaced below, so taking the reference saves a count
+		}
+		else
+		{
+			e = manager.makeEntity(s.id, tag);
+		}
+		manager.setActive(e, s.flags & ENTITY_ACTIVE);
+		applyEntity(*e, s, labels);
+		if ( s.flags & ENTITY_PENDING )
+		{
+			pending.push_back(std::move(e));
+		}
+		else
+		{
+			entities.push_back(std::move(e));
+			entityTags.push_back(s.tag);
+		}
+	}
+	manager.restore(entities, pending, in.total, kept, entityTags, tags);
+}
+
+void encodeWorld(const WorldState& state, ByteWriter& out)
+{
+	out.u32(STATE_MAGIC);
+	out.u16(STATE_VERSION);
+	out.u64(state.seed);
+	writeInt(out, state.score);
+	writeInt(out, state.highScore);
+	writeInt(out, state.currentFrame);
+	out.u8(state.paused);
+	out.varint(state.player);
+	out.varint(state.player2);
+	writeRng(out, state.spawnRng);
+	writeRng(out, state.labelRng);
+	out.varint(state.tags.size());
+	for (const std::string& tag : state.tags)
+	{
+		out.str(tag);
+	}
+	writeList(out, state.world);
+	writeColour(out, state.backCol);
+	out.varint(state.backFrames);
+	out.varint(state.backIndex);
+	writeRng(out, state.backRng);
+	writeList(out, state.back);
+}
+
+bool decodeWorld(ByteReader& in, WorldState& state)
+{
+	if ( in.u32() != STATE_MAGIC )
+	{
+		return false;
+	}
+	uint16_t version = in.u16();
+	if ( version < 1 || version > STATE_VERSION )
+	{
+		return false;
+	}
+	state.seed = in.u64();
+	state.score = readInt(in);
+	state.highScore = readInt(in);
+	state.currentFrame = readInt(in);
+	state.paused = in.u8();
+	state.player = in.varint();
+	state.player2 = (version >= 2) ? in.varint() : 0;
+	state.spawnRng = readRng(in);
+	state.labelRng = readRng(in);
+	size_t tags = in.varint();
+	if ( tags > 256 )
+	{
+		return false;
+	}
+	state.tags.resize(tags);
+	for (std::string& tag : state.tags)
+	{
+		tag = in.str();
+	}
+	if ( !readList(in, state.world, tags) )
+	{
+		return false;
+	}
+	state.backCol = readColour(in);
+	state.backFrames = in.varint();
+	state.backIndex = in.varint();
+	state.backRng = readRng(in);
+	
+	return readList(in, state.back, tags) && in.ok();
+}
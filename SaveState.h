@@ -0,0 +1,124 @@
+#pragma once
+
+#include "EntityManager.h"
+#include "Random.h"
+#include "Serialize.h"
+
+enum ComponentBit
+{
+	HAS_TRANSFORM = 1 << 0,
+	HAS_SHAPE = 1 << 1,
+	HAS_COLLISION = 1 << 2,
+	HAS_INPUT = 1 << 3,
+	HAS_SCORE = 1 << 4,
+	HAS_DURATION = 1 << 5,
+	HAS_DASH = 1 << 6,
+	HAS_LABEL = 1 << 7
+};
+
+enum EntityFlag
+{
+	ENTITY_ACTIVE = 1 << 0,
+	ENTITY_PENDING = 1 << 1 // added this tick, joins the entity list on the next update
+};
+
+const int COMPONENT_COUNT = 8;
+
+// component blocks are made of 32 bit words only, so they can be copied, compared and diffed a word at a time
+struct TransformState
+{
+	Vector2 pos;
+	Vector2 velocity;
+	float rotation;
+};
+
+struct ShapeState
+{
+	int32_t sides;
+	float radius;
+	Color colour;
+	Color outlineC;
+	int32_t outlineW;
+};
+
+struct DurationState
+{
+	int32_t lifespan;
+	int32_t frameCreated;
+};
+
+struct DashState
+{
+	int32_t frames;
+	int32_t frameStarted;
+	int32_t delay;
+	float speedMod;
+	int32_t active;
+};
+
+struct LabelState
+{
+	int32_t label; // index into the game's label strings, -1 is the empty label
+	float size;
+	Color colour;
+};
+
+// one entity with every component flattened into plain fields, absent components are left zeroed
+struct EntityState
+{
+	uint32_t id = 0;
+	uint8_t tag = 0; // index into WorldState::tags
+	uint8_t flags = 0;
+	uint8_t components = 0;
+	TransformState transform = {};
+	ShapeState shape = {};
+	float collision = 0;
+	uint32_t input = 0; // CInput, one bit per button in the order the members are declared
+	int32_t score = 0;
+	DurationState duration = {};
+	DashState dash = {};
+	LabelState label = {};
+};
+
+// the block of 32 bit words holding one component (by ComponentBit index) of an entity
+uint32_t* componentWords(EntityState& state, int component);
+const uint32_t* componentWords(const EntityState& state, int component);
+size_t componentSize(int component); // in words
+
+// one EntityManager: active entities first, then the pending ones, both in id order
+struct EntityListState
+{
+	uint32_t total = 0; // ids handed out so far
+	std::vector< EntityState > entities;
+};
+
+// everything needed to continue a game from an exact tick
+struct WorldState
+{
+	uint64_t seed = 0;
+	int32_t score = 0;
+	int32_t highScore = 0;
+	int32_t currentFrame = 0;
+	uint8_t paused = 0;
+	uint32_t player = 0; // id of the entity m_player points at
+	uint32_t player2 = 0; // id + 1 of the second player, 0 in one player games
+	RngState spawnRng;
+	RngState labelRng;
+	std::vector< std::string > tags;
+	EntityListState world;
+	// menu background
+	Color backCol = {0, 0, 0, 0};
+	uint32_t backFrames = 0;
+	uint32_t backIndex = 0;
+	RngState backRng;
+	EntityListState back;
+};
+
+// copies a manager's entities into plain records and back. Restoring reuses the live Entity objects and
+// components whose ids match, so rolling back a few ticks allocates almost nothing
+void captureEntities(EntityManager& manager, EntityListState& out, std::vector< std::string >& tags, const std::vector< const char* >& labels);
+void restoreEntities(EntityManager& manager, const EntityListState& in, const std::vector< std::string >& tags, const std::vector< const char* >& labels);
+
+// versioned binary format, the whole world in one contiguous buffer
+void encodeWorld(const WorldState& state, ByteWriter& out);
+bool decodeWorld(ByteReader& in, WorldState& state);
@@ -0,0 +1,238 @@
+#include "Serialize.h"
+#include <string.h>
+
+uint8_t* ByteWriter::grow(size_t size)
+{
+	if ( m_size + size > m_data.size() )
+	{
+		// grow geometrically so writing n bytes costs O(n) no matter how they are split up
+		m_data.resize((m_size + size) * 2);
+	}
+	uint8_t* p = m_data.data() + m_size;
+	m_size += size;
+	
+	return p;
+}
+
+void ByteWriter::u8(uint8_t v)
+{
+	*grow(1) = v;
+}
+
+void ByteWriter::u16(uint16_t v)
+{
+	uint8_t* p = grow(2);
+	p[0] = v;
+	p[1] = v >> 8;
+}
+
+void ByteWriter::u32(uint32_t v)
+{
+	uint8_t* p = grow(4);
+	p[0] = v;
+	p[1] = v >> 8;
+	p[2] = v >> 16;
+	p[3] = v >> 24;
+}
+
+void ByteWriter::u64(uint64_t v)
+{
+	u32(v);
+	u32(v >> 32);
+}
+
+void ByteWriter::i16(int16_t v)
+{
+	u16((uint16_t)v);
+}
+
+void ByteWriter::f32(float v)
+{
+	uint32_t bits;
+	memcpy(&bits, &v, sizeof(bits));
+	u32(bits);
+}
+
+void ByteWriter::varint(uint64_t v)
+{
+	uint8_t buffer[10];
+	size_t size = 0;
+	while ( v >= 0x80 )
+	{
+		buffer[size++] = (v & 0x7f) | 0x80;
+		v >>= 7;
+	}
+	buffer[size++] = v;
+	bytes(buffer, size);
+}
+
+void ByteWriter::bytes(const void* src, size_t size)
+{
+	memcpy(grow(size), src, size);
+}
+
+void ByteWriter::str(const std::string& s)
+{
+	varint(s.size());
+	bytes(s.data(), s.size());
+}
+
+void ByteWriter::clear()
+{
+	m_size = 0;
+}
+
+size_t ByteWriter::size() const
+{
+	return m_size;
+}
+
+std::vector< uint8_t >& ByteWriter::data()
+{
+	m_data.resize(m_size);
+	
+	return m_data;
+}
+
+const uint8_t* ByteWriter::buffer() const
+{
+	return m_data.data();
+}
+
+ByteReader::ByteReader(const uint8_t* data, size_t size)
+	: m_data(data), m_size(size) {}
+
+ByteReader::ByteReader(const std::vector< uint8_t >& data)
+	: m_data(data.data()), m_size(data.size()) {}
+
+bool ByteReader::take(size_t size)
+{
+	if ( !m_ok || m_size - m_pos < size )
+	{
+		m_ok = false;
+		return false;
+	}
+	
+	return true;
+}
+
+uint8_t ByteReader::u8()
+{
+	if ( !take(1) )
+	{
+		return 0;
+	}
+	
+	return m_data[m_pos++];
+}
+
+uint16_t ByteReader::u16()
+{
+	if ( !take(2) )
+	{
+		return 0;
+	}
+	const uint8_t* p = m_data + m_pos;
+	m_pos += 2;
+	
+	return p[0] | (p[1] << 8);
+}
+
+uint32_t ByteReader::u32()
+{
+	if ( !take(4) )
+	{
+		return 0;
+	}
+	const uint8_t* p = m_data + m_pos;
+	m_pos += 4;
+	
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+uint64_t ByteReader::u64()
+{
+	uint64_t low = u32();
+	
+	return low | ((uint64_t)u32() << 32);
+}
+
+int16_t ByteReader::i16()
+{
+	return (int16_t)u16();
+}
+
+float ByteReader::f32()
+{
+	uint32_t bits = u32();
+	float v;
+	memcpy(&v, &bits, sizeof(v));
+	
+	return v;
+}
+
+uint64_t ByteReader::varint()
+{
+	uint64_t v = 0;
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		if ( m_pos >= m_size )
+		{
+			m_ok = false;
+			return 0;
+		}
+		uint8_t b = m_data[m_pos++];
+		v |= (uint64_t)(b & 0x7f) << shift;
+		if ( !(b & 0x80) )
+		{
+			break;
+		}
+	}
+	
+	return v;
+}
+
+bool ByteReader::bytes(void* dst, size_t size)
+{
+	if ( !take(size) )
+	{
+		return false;
+	}
+	memcpy(dst, m_data + m_pos, size);
+	m_pos += size;
+	
+	return true;
+}
+
+std::string ByteReader::str()
+{
+	size_t size = varint();
+	if ( !take(size) )
+	{
+		return "";
+	}
+	std::string s((const char*)m_data + m_pos, size);
+	m_pos += size;
+	
+	return s;
+}
+
+bool ByteReader::ok() const
+{
+	return m_ok;
+}
+
+bool ByteReader::done() const
+{
+	return m_pos >= m_size;
+}
+
+size_t ByteReader::pos() const
+{
+	return m_pos;
+}
+
+size_t ByteReader::remaining() const
+{
+	return m_size - m_pos;
+}
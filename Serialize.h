@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+// little endian binary encoding shared by replays, save states and network messages
+class ByteWriter
+{
+private:
+	std::vector< uint8_t > m_data; // may run ahead of m_size, trimmed by data()
+	size_t m_size = 0;
+	uint8_t* grow(size_t size);
+public:
+	void u8(uint8_t v);
+	void u16(uint16_t v);
+	void u32(uint32_t v);
+	void u64(uint64_t v);
+	void i16(int16_t v);
+	void f32(float v);
+	void varint(uint64_t v); // 7 bits per byte, small numbers take one byte
+	void bytes(const void* src, size_t size);
+	void str(const std::string& s);
+	void clear();
+	size_t size() const;
+	std::vector< uint8_t >& data();
+	const uint8_t* buffer() const; // the first size() bytes, without trimming the spare capacity
+};
+
+// reads what ByteWriter wrote. Reading past the end returns zeroes and clears ok()
+class ByteReader
+{
+private:
+	const uint8_t* m_data;
+	size_t m_size;
+	size_t m_pos = 0;
+	bool m_ok = true;
+	bool take(size_t size);
+public:
+	ByteReader(const uint8_t* data, size_t size);
+	ByteReader(const std::vector< uint8_t >& data);
+	uint8_t u8();
+	uint16_t u16();
+	uint32_t u32();
+	uint64_t u64();
+	int16_t i16();
+	float f32();
+	uint64_t varint();
+	bool bytes(void* dst, size_t size);
+	std::string str();
+	bool ok() const;
+	bool done() const;
+	size_t pos() const;
+	size_t remaining() const;
+};
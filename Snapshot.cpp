@@ -0,0 +1,54 @@
+#include "Snapshot.h"
+
+void RenderSnapshot::clear()
+{
+	// keep the allocations around, a snapshot is rebuilt every tick
+	shapes.clear();
+	labels.clear();
+	stats = RenderStats();
+}
+
+void RenderSnapshot::cull(const Rectangle& view)
+{
+	// compact the visible shapes to the front, order is kept so draw order doesn't change
+	size_t kept = 0;
+	for (size_t i = 0; i < shapes.size(); i++)
+	{
+		const ShapeInstance& shape = shapes[i];
+		float bound = shape.radius + shape.outlineW;
+		if ( shape.pos.x + bound < view.x || shape.pos.x - bound > view.x + view.width || shape.pos.y + bound < view.y || shape.pos.y - bound > view.y + view.height )
+		{
+			continue;
+		}
+		shapes[kept++] = shape;
+	}
+	stats.culled = shapes.size() - kept;
+	stats.shapes = kept;
+	stats.labels = labels.size();
+	shapes.resize(kept);
+}
+
+void RenderSnapshot::addShape(const Vector2& pos, float rotation, int sides, float radius, const Color& fill, const Color& outline, int outlineW)
+{
+	shapes.push_back((ShapeInstance) {pos, radius, rotation, sides, outlineW, fill, outline});
+}
+
+void RenderSnapshot::addLabel(const Vector2& pos, const char* text, float size, const Color& colour)
+{
+	labels.push_back((LabelInstance) {pos, size, colour, text});
+}
+
+RenderSnapshot& SnapshotBuffer::back()
+{
+	return m_buffers[1 - m_front];
+}
+
+const RenderSnapshot& SnapshotBuffer::front() const
+{
+	return m_buffers[m_front];
+}
+
+void SnapshotBuffer::swap()
+{
+	m_front = 1 - m_front;
+}
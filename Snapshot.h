@@ -0,0 +1,63 @@
+#pragma once
+
+#include "raylib.h"
+#include <vector>
+#include <stddef.h>
+
+// everything the renderer needs to draw one simulation tick. Filled by the simulation, read only by sRender
+struct ShapeInstance
+{
+	Vector2 pos;
+	float radius;
+	float rotation;
+	int sides;
+	int outlineW;
+	Color fill;
+	Color outline;
+};
+
+struct LabelInstance
+{
+	Vector2 pos;
+	float size;
+	Color colour;
+	const char* text; // points at label strings owned by Game, never freed while running
+};
+
+struct RenderStats
+{
+	size_t shapes = 0; // shapes submitted for drawing
+	size_t culled = 0; // shapes skipped because they were off-screen
+	size_t labels = 0;
+};
+
+struct RenderSnapshot
+{
+	Color background = BLACK;
+	std::vector< ShapeInstance > shapes;
+	std::vector< LabelInstance > labels;
+	int score = 0;
+	int highScore = 0;
+	int seconds = 0;
+	bool paused = true;
+	size_t tick = 0;
+	RenderStats stats;
+	
+	void clear();
+	void cull(const Rectangle& view);
+	void addShape(const Vector2& pos, float rotation, int sides, float radius, const Color& fill, const Color& outline, int outlineW);
+	void addLabel(const Vector2& pos, const char* text, float size, const Color& colour);
+};
+
+// double buffer of snapshots. The simulation writes back() while the renderer reads front()
+// swap() must only be called while neither side is touching a buffer
+class SnapshotBuffer
+{
+private:
+	RenderSnapshot m_buffers[2];
+	size_t m_front = 0;
+public:
+	RenderSnapshot& back();
+	const RenderSnapshot& front() const;
+	void swap();
+};
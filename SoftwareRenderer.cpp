@@ -0,0 +1,321 @@
+#include "SoftwareRenderer.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace
+{
+	// 5x7 dot font covering ' ' to 'Z', one byte per row with the leftmost dot in bit 4
+	const int GLYPH_W = 5;
+	const int GLYPH_H = 7;
+	const int GLYPH_ADVANCE = 6;
+	const int MAX_SIDES = 64;
+	const unsigned char GLYPHS[59][GLYPH_H] = {
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // ' '
+	{0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04}, // '!'
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '"' (not drawn)
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '#' (not drawn)
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '$' (not drawn)
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '%' (not drawn)
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '&' (not drawn)
+	{0x04, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00}, // '\''
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '(' (not drawn)
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // ')' (not drawn)
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '*' (not drawn)
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '+' (not drawn)
+	{0x00, 0x00, 0x00, 0x00, 0x06, 0x04, 0x08}, // ','
+	{0x00, 0x00, 0x00, 0x0E, 0x00, 0x00, 0x00}, // '-'
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C}, // '.'
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '/' (not drawn)
+	{0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E}, // '0'
+	{0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E}, // '1'
+	{0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F}, // '2'
+	{0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E}, // '3'
+	{0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02}, // '4'
+	{0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E}, // '5'
+	{0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E}, // '6'
+	{0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08}, // '7'
+	{0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E}, // '8'
+	{0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C}, // '9'
+	{0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00}, // ':'
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // ';' (not drawn)
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '<' (not drawn)
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '=' (not drawn)
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '>' (not drawn)
+	{0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04}, // '?'
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // '@' (not drawn)
+	{0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11}, // 'A'
+	{0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E}, // 'B'
+	{0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E}, // 'C'
+	{0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C}, // 'D'
+	{0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F}, // 'E'
+	{0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10}, // 'F'
+	{0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F}, // 'G'
+	{0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11}, // 'H'
+	{0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E}, // 'I'
+	{0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C}, // 'J'
+	{0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11}, // 'K'
+	{0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F}, // 'L'
+	{0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11}, // 'M'
+	{0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11}, // 'N'
+	{0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}, // 'O'
+	{0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10}, // 'P'
+	{0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D}, // 'Q'
+	{0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11}, // 'R'
+	{0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E}, // 'S'
+	{0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04}, // 'T'
+	{0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}, // 'U'
+	{0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04}, // 'V'
+	{0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A}, // 'W'
+	{0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11}, // 'X'
+	{0x11, 0x11, 0x0A, 0x04, 0x04, 0x04, 0x04}, // 'Y'
+	{0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F}, // 'Z'
+	};
+	
+	bool glyphDot(char c, int x, int y)
+	{
+		if ( c >= 'a' && c <= 'z' )
+		{
+			c -= 'a' - 'A';
+		}
+		if ( c < ' ' || c > 'Z' || x < 0 || x >= GLYPH_W || y < 0 || y >= GLYPH_H )
+		{
+			return false;
+		}
+		
+		return GLYPHS[c - ' '][y] & (1 << (GLYPH_W - 1 - x));
+	}
+	
+	void blend(Color& dst, const Color& src)
+	{
+		if ( src.a == 255 )
+		{
+			dst = src;
+			return;
+		}
+		int a = src.a;
+		int ia = 255 - a;
+		dst.r = (src.r * a + dst.r * ia) / 255;
+		dst.g = (src.g * a + dst.g * ia) / 255;
+		dst.b = (src.b * a + dst.b * ia) / 255;
+		dst.a = a + dst.a * ia / 255;
+	}
+	
+	// same vertex placement as raylib's DrawPoly
+	void polygon(const ShapeInstance& shape, float radius, Vector2* verts, int sides)
+	{
+		float c = cosf(DEG2RAD * shape.rotation);
+		float s = sinf(DEG2RAD * shape.rotation);
+		for (int i = 0; i < sides; i++)
+		{
+			float angle = DEG2RAD * 360.0f * i / sides;
+			float x = sinf(angle) * radius;
+			float y = cosf(angle) * radius;
+			verts[i] = (Vector2) {shape.pos.x + x * c - y * s, shape.pos.y + x * s + y * c};
+		}
+	}
+	
+	bool inside(const Vector2* verts, int sides, float x, float y)
+	{
+		// convex polygon: the point must be on the same side of every edge
+		bool positive = false;
+		bool negative = false;
+		for (int i = 0; i < sides; i++)
+		{
+			const Vector2& a = verts[i];
+			const Vector2& b = verts[(i + 1) % sides];
+			float cross = (b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x);
+			positive = positive || cross > 0;
+			negative = negative || cross < 0;
+			if ( positive && negative )
+			{
+				return false;
+			}
+		}
+		
+		return true;
+	}
+}
+
+SoftwareRenderer::SoftwareRenderer(int width, int height, float fontSize, const Color& fontColour, size_t threads)
+	: m_width(width), m_height(height), m_fontSize(fontSize), m_fontColour(fontColour), m_pool(threads)
+{
+	m_tilesX = (width + TILE - 1) / TILE;
+	m_tilesY = (height + TILE - 1) / TILE;
+	m_pixels.resize(width * height);
+	m_bins.resize(m_tilesX * m_tilesY);
+}
+
+void SoftwareRenderer::addText(const char* text, const Vector2& pos, float size, const Color& colour)
+{
+	TextItem item;
+	strncpy(item.text, text, sizeof(item.text) - 1);
+	item.text[sizeof(item.text) - 1] = '\0';
+	item.pos = pos;
+	// the default raylib font is 10 pixels tall, scale the dots so text takes up about the same room
+	item.scale = (size / 10 > 1) ? size / 10 : 1;
+	item.colour = colour;
+	float width = (strlen(item.text) * GLYPH_ADVANCE - 1) * item.scale;
+	item.bounds = (Rectangle) {pos.x, pos.y, width, GLYPH_H * item.scale};
+	m_text.push_back(item);
+}
+
+void SoftwareRenderer::draw(const RenderSnapshot& frame)
+{
+	for (auto& bin : m_bins)
+	{
+		bin.clear();
+	}
+	for (size_t i = 0; i < frame.shapes.size(); i++)
+	{
+		const ShapeInstance& shape = frame.shapes[i];
+		float bound = shape.radius + shape.outlineW;
+		int x0 = (int)floorf((shape.pos.x - bound) / TILE);
+		int x1 = (int)floorf((shape.pos.x + bound) / TILE);
+		int y0 = (int)floorf((shape.pos.y - bound) / TILE);
+		int y1 = (int)floorf((shape.pos.y + bound) / TILE);
+		x0 = (x0 < 0) ? 0 : x0;
+		y0 = (y0 < 0) ? 0 : y0;
+		x1 = (x1 >= m_tilesX) ? m_tilesX - 1 : x1;
+		y1 = (y1 >= m_tilesY) ? m_tilesY - 1 : y1;
+		for (int ty = y0; ty <= y1; ty++)
+		{
+			for (int tx = x0; tx <= x1; tx++)
+			{
+				m_bins[ty * m_tilesX + tx].push_back(i);
+			}
+		}
+	}
+	m_text.clear();
+	HudLine lines[3];
+	hudLines(frame, m_fontSize, m_width, lines);
+	for (int i = 0; i < 3; i++)
+	{
+		char buffer[64];
+		snprintf(buffer, sizeof(buffer), "%s%d", lines[i].prefix, lines[i].value);
+		addText(buffer, lines[i].pos, m_fontSize, m_fontColour);
+	}
+	for (const LabelInstance& label : frame.labels)
+	{
+		addText(label.text, label.pos, label.size, label.colour);
+	}
+	m_pool.parallelFor(m_bins.size(), [&](size_t tile) { drawTile(frame, tile); });
+}
+
+void SoftwareRenderer::drawTile(const RenderSnapshot& frame, size_t tile)
+{
+	int left = (tile % m_tilesX) * TILE;
+	int top = (tile / m_tilesX) * TILE;
+	int right = (left + TILE < m_width) ? left + TILE : m_width;
+	int bottom = (top + TILE < m_height) ? top + TILE : m_height;
+	for (int y = top; y < bottom; y++)
+	{
+		for (int x = left; x < right; x++)
+		{
+			m_pixels[y * m_width + x] = frame.background;
+		}
+	}
+	Vector2 fill[MAX_SIDES];
+	Vector2 outer[MAX_SIDES];
+	Vector2 inner[MAX_SIDES];
+	for (unsigned int index : m_bins[tile])
+	{
+		const ShapeInstance& shape = frame.shapes[index];
+		int sides = (shape.sides < 3) ? 3 : (shape.sides > MAX_SIDES) ? MAX_SIDES : shape.sides;
+		float bound = shape.radius + shape.outlineW;
+		int x0 = (int)floorf(shape.pos.x - bound);
+		int x1 = (int)ceilf(shape.pos.x + bound);
+		int y0 = (int)floorf(shape.pos.y - bound);
+		int y1 = (int)ceilf(shape.pos.y + bound);
+		x0 = (x0 < left) ? left : x0;
+		y0 = (y0 < top) ? top : y0;
+		x1 = (x1 > right) ? right : x1;
+		y1 = (y1 > bottom) ? bottom : y1;
+		polygon(shape, shape.radius, fill, sides);
+		// an outline of width w is w one pixel rings starting at the shape's radius, rasterized here as one band
+		if ( shape.outlineW > 0 )
+		{
+			polygon(shape, shape.radius + shape.outlineW - 0.5f, outer, sides);
+			polygon(shape, shape.radius - 0.5f, inner, sides);
+		}
+		for (int y = y0; y < y1; y++)
+		{
+			for (int x = x0; x < x1; x++)
+			{
+				float px = x + 0.5f;
+				float py = y + 0.5f;
+				Color& pixel = m_pixels[y * m_width + x];
+				if ( inside(fill, sides, px, py) )
+				{
+					blend(pixel, shape.fill);
+				}
+				if ( shape.outlineW > 0 && inside(outer, sides, px, py) && !inside(inner, sides, px, py) )
+				{
+					blend(pixel, shape.outline);
+				}
+			}
+		}
+	}
+	for (const TextItem& item : m_text)
+	{
+		const Rectangle& b = item.bounds;
+		if ( b.x >= right || b.x + b.width <= left || b.y >= bottom || b.y + b.height <= top )
+		{
+			continue;
+		}
+		int x0 = (b.x > left) ? (int)b.x : left;
+		int y0 = (b.y > top) ? (int)b.y : top;
+		int x1 = (b.x + b.width < right) ? (int)ceilf(b.x + b.width) : right;
+		int y1 = (b.y + b.height < bottom) ? (int)ceilf(b.y + b.height) : bottom;
+		for (int y = y0; y < y1; y++)
+		{
+			int dotY = (int)floorf((y + 0.5f - item.pos.y) / item.scale);
+			for (int x = x0; x < x1; x++)
+			{
+				int dotX = (int)floorf((x + 0.5f - item.pos.x) / item.scale);
+				if ( dotX < 0 )
+				{
+					continue;
+				}
+				if ( glyphDot(item.text[dotX / GLYPH_ADVANCE], dotX % GLYPH_ADVANCE, dotY) )
+				{
+					blend(m_pixels[y * m_width + x], item.colour);
+				}
+			}
+		}
+	}
+}
+
+const std::vector< Color >& SoftwareRenderer::pixels() const
+{
+	return m_pixels;
+}
+
+int SoftwareRenderer::width() const
+{
+	return m_width;
+}
+
+int SoftwareRenderer::height() const
+{
+	return m_height;
+}
+
+bool SoftwareRenderer::savePPM(const char* file) const
+{
+	FILE* out = fopen(file, "wb");
+	if ( !out )
+	{
+		return false;
+	}
+	fprintf(out, "P6\n%d %d\n255\n", m_width, m_height);
+	for (const Color& pixel : m_pixels)
+	{
+		fputc(pixel.r, out);
+		fputc(pixel.g, out);
+		fputc(pixel.b, out);
+	}
+	fclose(out);
+	
+	return true;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Renderer.h"
+#include "ThreadPool.h"
+#include <vector>
+
+// draws snapshots on the CPU into an in-memory RGBA image, no window or GPU needed.
+// The screen is split into square tiles that are rasterized in parallel
+class SoftwareRenderer : public Renderer
+{
+private:
+	struct TextItem
+	{
+		char text[64];
+		Vector2 pos;
+		float scale; // pixels per glyph dot
+		Color colour;
+		Rectangle bounds;
+	};
+	int m_width;
+	int m_height;
+	int m_tilesX;
+	int m_tilesY;
+	float m_fontSize;
+	Color m_fontColour;
+	std::vector< Color > m_pixels;
+	std::vector< std::vector< unsigned int > > m_bins; // shape indices overlapping each tile, in draw order
+	std::vector< TextItem > m_text;
+	ThreadPool m_pool;
+	void addText(const char* text, const Vector2& pos, float size, const Color& colour);
+	void drawTile(const RenderSnapshot& frame, size_t tile);
+public:
+	static const int TILE = 64; // tile edge (pixels)
+	SoftwareRenderer(int width, int height, float fontSize = 20, const Color& fontColour = WHITE, size_t threads = 0);
+	void draw(const RenderSnapshot& frame) override;
+	const std::vector< Color >& pixels() const;
+	int width() const;
+	int height() const;
+	bool savePPM(const char* file) const;
+};
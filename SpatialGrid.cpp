@@ -0,0 +1,136 @@
+#include "SpatialGrid.h"
+#include <algorithm>
+#include <math.h>
+
+SpatialGrid::SpatialGrid(float width, float height, float cellSize)
+{
+	resize(width, height, cellSize);
+}
+
+void SpatialGrid::resize(float width, float height, float cellSize)
+{
+	m_cellSize = cellSize;
+	m_cols = std::max(1, (int)ceilf(width / cellSize));
+	m_rows = std::max(1, (int)ceilf(height / cellSize));
+	m_start.assign(m_cols * m_rows + 1, 0);
+	m_items.clear();
+}
+
+int SpatialGrid::column(float x) const
+{
+	return std::min(std::max((int)(x / m_cellSize), 0), m_cols - 1);
+}
+
+int SpatialGrid::row(float y) const
+{
+	return std::min(std::max((int)(y / m_cellSize), 0), m_rows - 1);
+}
+
+void SpatialGrid::build(const EntityVec& entities)
+{
+	const uint32_t SKIP = (uint32_t)-1;
+	size_t cellCount = m_cols * m_rows;
+	std::fill(m_start.begin(), m_start.end(), 0);
+	m_cells.resize(entities.size());
+	size_t count = 0;
+	for (size_t i = 0; i < entities.size(); i++)
+	{
+		const Entity& e = *entities[i];
+		if ( !e.cTransform )
+		{
+			m_cells[i] = SKIP;
+			continue;
+		}
+		m_cells[i] = row(e.cTransform->pos.y) * m_cols + column(e.cTransform->pos.x);
+		m_start[m_cells[i] + 1]++;
+		count++;
+	}
+	for (size_t c = 0; c < cellCount; c++)
+	{
+		m_start[c + 1] += m_start[c];
+	}
+	m_items.resize(count);
+	// place each item at its cell's running offset, m_start is shifted back into shape afterwards
+	for (size_t i = 0; i < entities.size(); i++)
+	{
+		if ( m_cells[i] != SKIP )
+		{
+			const Entity& e = *entities[i];
+			m_items[m_start[m_cells[i]]++] = (GridItem) {e.cTransform->pos, &e};
+		}
+	}
+	for (size_t c = cellCount; c > 0; c--)
+	{
+		m_start[c] = m_start[c - 1];
+	}
+	m_start[0] = 0;
+}
+
+size_t SpatialGrid::nearest(Vector2 pos, size_t k, const GridItem** out, float* distSq) const
+{
+	if ( k == 0 || m_items.empty() )
+	{
+		return 0;
+	}
+	int cx = column(pos.x);
+	int cy = row(pos.y);
+	int maxRing = std::max(std::max(cx, m_cols - 1 - cx), std::max(cy, m_rows - 1 - cy));
+	size_t found = 0;
+	for (int ring = 0; ring <= maxRing; ring++)
+	{
+		// every cell in this ring is at least (ring - 1) cells away, so once we have k closer than that we're done
+		if ( found == k )
+		{
+			float reach = (ring - 1) * m_cellSize;
+			if ( ring > 1 && distSq[k - 1] <= reach * reach )
+			{
+				break;
+			}
+		}
+		for (int y = cy - ring; y <= cy + ring; y++)
+		{
+			if ( y < 0 || y >= m_rows )
+			{
+				continue;
+			}
+			// inner rows only have the two edge cells of the ring
+			int step = (y == cy - ring || y == cy + ring) ? 1 : 2 * ring;
+			for (int x = cx - ring; x <= cx + ring; x += step)
+			{
+				if ( x < 0 || x >= m_cols )
+				{
+					continue;
+				}
+				size_t cell = y * m_cols + x;
+				for (uint32_t i = m_start[cell]; i < m_start[cell + 1]; i++)
+				{
+					const GridItem& item = m_items[i];
+					float dx = item.pos.x - pos.x;
+					float dy = item.pos.y - pos.y;
+					float d = dx * dx + dy * dy;
+					if ( found == k && d >= distSq[k - 1] )
+					{
+						continue;
+					}
+					// insertion into the sorted k best
+					size_t j = (found < k) ? found++ : k - 1;
+					while ( j > 0 && distSq[j - 1] > d )
+					{
+						distSq[j] = distSq[j - 1];
+						out[j] = out[j - 1];
+						j--;
+					}
+					distSq[j] = d;
+					out[j] = &item;
+				}
+			}
+		}
+	}
+
+	return found;
+}
+
+size_t SpatialGrid::size() const
+{
+	return m_items.size();
+}
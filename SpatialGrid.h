@@ -0,0 +1,32 @@
+#pragma once
+
+#include "EntityManager.h"
+
+struct GridItem
+{
+	Vector2 pos;
+	const Entity* entity;
+};
+
+// uniform grid over the window, rebuilt from an entity list with a counting sort. Its buffers only ever grow,
+// so rebuilding every tick stops allocating once the biggest list has been seen. Positions off the window
+// are filed under the nearest edge cell
+class SpatialGrid
+{
+private:
+	float m_cellSize = 64;
+	int m_cols = 1;
+	int m_rows = 1;
+	std::vector< uint32_t > m_start; // first item of each cell, plus one past the end
+	std::vector< uint32_t > m_cells; // cell of each entity in the list being built, scratch
+	std::vector< GridItem > m_items; // sorted by cell
+	int column(float x) const;
+	int row(float y) const;
+public:
+	SpatialGrid(float width = 1280, float height = 720, float cellSize = 64);
+	void resize(float width, float height, float cellSize);
+	void build(const EntityVec& entities); // entities without a transform are left out
+	// the k closest items to pos, nearest first. Returns how many were found
+	size_t nearest(Vector2 pos, size_t k, const GridItem** out, float* distSq) const;
+	size_t size() const;
+};
@@ -0,0 +1,619 @@
+#include "Spectator.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <math.h>
+#include <string.h>
+#if !defined(PLATFORM_WEB)
+	#include <sys/socket.h>
+	#include <netinet/in.h>
+	#include <netinet/tcp.h>
+	#include <arpa/inet.h>
+	#include <errno.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+namespace
+{
+	const size_t MAX_MESSAGE = 16 * 1024 * 1024;
+
+	// what a list entry does between the viewer's frame and the new one, packed under the id gap
+	enum SpecOp
+	{
+		OP_CHANGE = 0,
+		OP_REMOVE = 1,
+		OP_ADD = 2
+	};
+
+	// small negative differences take one byte too
+	uint64_t zigzag(int32_t v)
+	{
+		return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+	}
+
+	int32_t unzigzag(uint64_t v)
+	{
+		return (int32_t)((uint32_t)(v >> 1) ^ -(uint32_t)(v & 1));
+	}
+
+	int32_t quarter(float v)
+	{
+		return (int32_t)lroundf(v * 4);
+	}
+
+	int32_t turn(float degrees)
+	{
+		return (int32_t)lroundf(fmodf(degrees, 360) / 360 * 256) & 255;
+	}
+
+	// fields that differ from the base, with the difference, or every nonzero field of an added entity
+	void writeFields(ByteWriter& out, const int32_t* from, const int32_t* to)
+	{
+		uint32_t mask = 0;
+		for (int f = 0; f < SPEC_FIELDS; f++)
+		{
+			mask |= (uint32_t)(from[f] != to[f]) << f;
+		}
+		out.varint(mask);
+		for (int f = 0; f < SPEC_FIELDS; f++)
+		{
+			if ( mask & (1 << f) )
+			{
+				out.varint(zigzag(to[f] - from[f]));
+			}
+		}
+	}
+
+	void readFields(ByteReader& in, int32_t* fields)
+	{
+		uint32_t mask = in.varint();
+		for (int f = 0; f < SPEC_FIELDS; f++)
+		{
+			if ( mask & (1 << f) )
+			{
+				fields[f] += unzigzag(in.varint());
+			}
+		}
+	}
+
+	void writeMessage(std::vector< uint8_t >& pending, const ByteWriter& message)
+	{
+		uint32_t size = message.size();
+		uint8_t header[4] = {(uint8_t)size, (uint8_t)(size >> 8), (uint8_t)(size >> 16), (uint8_t)(size >> 24)};
+		pending.insert(pending.end(), header, header + 4);
+		pending.insert(pending.end(), message.buffer(), message.buffer() + message.size());
+	}
+}
+
+uint8_t paletteIndex(const Color& colour)
+{
+	int high = std::max(colour.r, std::max(colour.g, colour.b));
+	int low = std::min(colour.r, std::min(colour.g, colour.b));
+	if ( high - low <= 8 )
+	{
+		// near greys get the finer ramp, the cube only has six
+		return 216 + (colour.r * 39 + 127) / 255;
+	}
+
+	return (colour.r * 5 + 127) / 255 * 36 + (colour.g * 5 + 127) / 255 * 6 + (colour.b * 5 + 127) / 255;
+}
+
+Color paletteColour(uint8_t index, uint8_t alpha)
+{
+	unsigned char a = (alpha & 15) * 17;
+	if ( index >= 216 )
+	{
+		unsigned char v = (index - 216) * 255 / 39;
+		return (Color) {v, v, v, a};
+	}
+
+	return (Color) {(unsigned char)(index / 36 * 51), (unsigned char)(index / 6 % 6 * 51), (unsigned char)(index % 6 * 51), a};
+}
+
+void SpecFrame::clear()
+{
+	entities.clear();
+}
+
+void SpecFrame::addShape(uint32_t id, const Vector2& pos, float rotation, int sides, float radius, const Color& fill, const Color& outline, int outlineW)
+{
+	SpecEntity e = {id, SPEC_SHAPE, {}};
+	e.fields[SPEC_X] = quarter(pos.x);
+	e.fields[SPEC_Y] = quarter(pos.y);
+	e.fields[SPEC_ROTATION] = turn(rotation);
+	e.fields[SPEC_SIDES] = sides;
+	e.fields[SPEC_RADIUS] = quarter(radius);
+	e.fields[SPEC_OUTLINE_W] = outlineW;
+	e.fields[SPEC_FILL] = paletteIndex(fill);
+	e.fields[SPEC_FILL_ALPHA] = fill.a >> 4;
+	e.fields[SPEC_OUTLINE] = paletteIndex(outline);
+	e.fields[SPEC_OUTLINE_ALPHA] = outline.a >> 4;
+	entities.push_back(e);
+}
+
+void SpecFrame::addLabel(uint32_t id, const Vector2& pos, int text, float size, const Color& colour)
+{
+	SpecEntity e = {id, SPEC_LABEL, {}};
+	e.fields[SPEC_X] = quarter(pos.x);
+	e.fields[SPEC_Y] = quarter(pos.y);
+	e.fields[SPEC_FILL] = paletteIndex(colour);
+	e.fields[SPEC_FILL_ALPHA] = colour.a >> 4;
+	e.fields[SPEC_TEXT] = text;
+	e.fields[SPEC_SIZE] = (int32_t)size;
+	entities.push_back(e);
+}
+
+void SpecFrame::draw(RenderSnapshot& frame, const std::vector< const char* >& labels) const
+{
+	frame.clear();
+	frame.background = paletteColour(background);
+	for (const SpecEntity& e : entities)
+	{
+		const int32_t* f = e.fields;
+		Vector2 pos = {f[SPEC_X] / 4.0f, f[SPEC_Y] / 4.0f};
+		if ( e.kind == SPEC_SHAPE )
+		{
+			frame.addShape(pos, f[SPEC_ROTATION] * 360.0f / 256, f[SPEC_SIDES], f[SPEC_RADIUS] / 4.0f, paletteColour(f[SPEC_FILL], f[SPEC_FILL_ALPHA]), paletteColour(f[SPEC_OUTLINE], f[SPEC_OUTLINE_ALPHA]), f[SPEC_OUTLINE_W]);
+		}
+		else if ( f[SPEC_TEXT] >= 0 && f[SPEC_TEXT] < (int32_t)labels.size() )
+		{
+			frame.addLabel(pos, labels[f[SPEC_TEXT]], f[SPEC_SIZE], paletteColour(f[SPEC_FILL], f[SPEC_FILL_ALPHA]));
+		}
+	}
+	frame.score = score;
+	frame.highScore = highScore;
+	frame.seconds = seconds;
+	frame.paused = false; // the menu is the player's, viewers just see the game
+	frame.tick = seq;
+}
+
+void encodeSpecFrame(const SpecFrame* base, const SpecFrame& frame, ByteWriter& out)
+{
+	// a full frame is a delta from nothing
+	static const SpecFrame empty;
+	const SpecFrame& from = (base) ? *base : empty;
+	out.varint(frame.seq);
+	out.varint(from.seq);
+	out.varint(zigzag(frame.score));
+	out.varint(zigzag(frame.highScore));
+	out.varint(zigzag(frame.seconds));
+	out.u8(frame.background);
+	// both lists are in id order, walk them together
+	ByteWriter ops;
+	size_t count = 0;
+	uint32_t lastId = 0;
+	size_t f = 0;
+	size_t t = 0;
+	static const int32_t zeroes[SPEC_FIELDS] = {};
+	while ( f < from.entities.size() || t < frame.entities.size() )
+	{
+		const SpecEntity* fe = (f < from.entities.size()) ? &from.entities[f] : nullptr;
+		const SpecEntity* te = (t < frame.entities.size()) ? &frame.entities[t] : nullptr;
+		if ( fe && te && fe->id == te->id && fe->kind == te->kind )
+		{
+			if ( memcmp(fe->fields, te->fields, sizeof(fe->fields)) != 0 )
+			{
+				ops.varint((uint64_t)(te->id - lastId) << 2 | OP_CHANGE);
+				writeFields(ops, fe->fields, te->fields);
+				lastId = te->id;
+				count++;
+			}
+			f++;
+			t++;
+		}
+		else if ( fe && (!te || fe->id <= te->id) )
+		{
+			ops.varint((uint64_t)(fe->id - lastId) << 2 | OP_REMOVE);
+			lastId = fe->id;
+			count++;
+			f++;
+		}
+		else
+		{
+			ops.varint((uint64_t)(te->id - lastId) << 2 | OP_ADD);
+			ops.u8(te->kind);
+			writeFields(ops, zeroes, te->fields);
+			lastId = te->id;
+			count++;
+			t++;
+		}
+	}
+	out.varint(count);
+	out.bytes(ops.buffer(), ops.size());
+}
+
+bool decodeSpecFrame(ByteReader& in, SpecFrame& frame)
+{
+	uint32_t seq = in.varint();
+	uint32_t base = in.varint();
+	if ( base != 0 && base != frame.seq )
+	{
+		return false; // a delta against a frame we don't have
+	}
+	if ( base == 0 )
+	{
+		frame.clear();
+	}
+	frame.seq = seq;
+	frame.score = unzigzag(in.varint());
+	frame.highScore = unzigzag(in.varint());
+	frame.seconds = unzigzag(in.varint());
+	frame.background = in.u8();
+	size_t count = in.varint();
+	if ( count > in.remaining() )
+	{
+		return false;
+	}
+	std::vector< SpecEntity > result;
+	result.reserve(frame.entities.size() + count);
+	size_t cursor = 0;
+	uint32_t id = 0;
+	for (size_t i = 0; i < count && in.ok(); i++)
+	{
+		uint64_t key = in.varint();
+		id += key >> 2;
+		SpecOp op = (SpecOp)(key & 3);
+		while ( cursor < frame.entities.size() && frame.entities[cursor].id < id )
+		{
+			result.push_back(frame.entities[cursor++]);
+		}
+		bool here = cursor < frame.entities.size() && frame.entities[cursor].id == id;
+		if ( op == OP_CHANGE )
+		{
+			if ( !here )
+			{
+				return false;
+			}
+			SpecEntity e = frame.entities[cursor++];
+			readFields(in, e.fields);
+			result.push_back(e);
+		}
+		else if ( op == OP_REMOVE )
+		{
+			if ( !here )
+			{
+				return false;
+			}
+			cursor++;
+		}
+		else
+		{
+			SpecEntity e = {id, in.u8(), {}};
+			readFields(in, e.fields);
+			result.push_back(e);
+		}
+	}
+	while ( cursor < frame.entities.size() )
+	{
+		result.push_back(frame.entities[cursor++]);
+	}
+	frame.entities.swap(result);
+
+	return in.ok();
+}
+
+SpectatorServer::~SpectatorServer()
+{
+	close();
+}
+
+size_t SpectatorServer::viewers() const
+{
+	return m_viewers.size();
+}
+
+size_t SpectatorServer::bytes() const
+{
+	return m_bytes;
+}
+
+size_t SpectatorServer::skipped() const
+{
+	return m_skipped;
+}
+
+uint32_t SpectatorServer::frames() const
+{
+	return m_seq;
+}
+
+SpectatorClient::~SpectatorClient()
+{
+	close();
+}
+
+bool SpectatorClient::connected() const
+{
+	return m_socket >= 0;
+}
+
+const SpecFrame& SpectatorClient::frame() const
+{
+	return m_frame;
+}
+
+size_t SpectatorClient::bytes() const
+{
+	return m_bytes;
+}
+
+size_t SpectatorClient::frames() const
+{
+	return m_frames;
+}
+
+#if defined(PLATFORM_WEB)
+// no sockets in the browser
+bool SpectatorServer::listen(uint16_t port, size_t bytesPerSecond)
+{
+	return false;
+}
+
+void SpectatorServer::publish(SpecFrame& frame)
+{
+}
+
+void SpectatorServer::accept()
+{
+}
+
+bool SpectatorServer::flush(Viewer& viewer)
+{
+	return false;
+}
+
+void SpectatorServer::close()
+{
+}
+
+bool SpectatorClient::connect(const char* address, uint16_t port)
+{
+	return false;
+}
+
+bool SpectatorClient::poll()
+{
+	return false;
+}
+
+void SpectatorClient::close()
+{
+}
+#else
+bool SpectatorServer::listen(uint16_t port, size_t bytesPerSecond)
+{
+	close();
+	m_listen = socket(AF_INET, SOCK_STREAM, 0);
+	if ( m_listen < 0 )
+	{
+		return false;
+	}
+	int yes = 1;
+	setsockopt(m_listen, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+	sockaddr_in local = {};
+	local.sin_family = AF_INET;
+	local.sin_addr.s_addr = htonl(INADDR_ANY);
+	local.sin_port = htons(port);
+	if ( ::bind(m_listen, (sockaddr*)&local, sizeof(local)) < 0 || ::listen(m_listen, 64) < 0 )
+	{
+		close();
+		return false;
+	}
+	fcntl(m_listen, F_SETFL, O_NONBLOCK);
+	m_rate = bytesPerSecond;
+	m_history.assign(SPECTATOR_HISTORY, SpecFrame());
+
+	return true;
+}
+
+void SpectatorServer::accept()
+{
+	int socket;
+	while ( (socket = ::accept(m_listen, nullptr, nullptr)) >= 0 )
+	{
+		fcntl(socket, F_SETFL, O_NONBLOCK);
+		int yes = 1;
+		setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+		Viewer viewer = {socket, 0, {}, (double)m_rate};
+		ByteWriter hello;
+		hello.u32(SPECTATOR_MAGIC);
+		viewer.pending.assign(hello.buffer(), hello.buffer() + hello.size());
+		m_viewers.push_back(viewer);
+	}
+}
+
+bool SpectatorServer::flush(Viewer& viewer)
+{
+	if ( viewer.pending.empty() )
+	{
+		return true;
+	}
+	ssize_t sent = send(viewer.socket, viewer.pending.data(), viewer.pending.size(), MSG_NOSIGNAL);
+	if ( sent < 0 )
+	{
+		return errno == EAGAIN || errno == EWOULDBLOCK;
+	}
+	viewer.pending.erase(viewer.pending.begin(), viewer.pending.begin() + sent);
+	m_bytes += sent;
+
+	return true;
+}
+
+void SpectatorServer::publish(SpecFrame& frame)
+{
+	if ( m_listen < 0 )
+	{
+		return;
+	}
+	auto now = std::chrono::steady_clock::now();
+	double elapsed = (m_seq == 0) ? 0 : std::chrono::duration<double>(now - m_lastPublish).count();
+	m_lastPublish = now;
+	accept();
+	frame.seq = ++m_seq;
+	m_history[frame.seq % SPECTATOR_HISTORY] = frame;
+	// viewers that are in step share a base, so each distinct base is only encoded once per frame
+	std::vector< std::pair< uint32_t, ByteWriter > > encoded;
+	size_t kept = 0;
+	for (size_t v = 0; v < m_viewers.size(); v++)
+	{
+		Viewer& viewer = m_viewers[v];
+		viewer.tokens = std::min(viewer.tokens + elapsed * m_rate, (double)m_rate);
+		if ( !flush(viewer) )
+		{
+			::close(viewer.socket);
+			continue;
+		}
+		if ( !viewer.pending.empty() )
+		{
+			// still sending an older frame, this one's skipped and the next delta covers it
+			m_skipped++;
+			m_viewers[kept++] = std::move(viewer);
+			continue;
+		}
+		const SpecFrame& old = m_history[viewer.base % SPECTATOR_HISTORY];
+		uint32_t base = (viewer.base != 0 && m_seq - viewer.base < SPECTATOR_HISTORY && old.seq == viewer.base) ? viewer.base : 0;
+		size_t e = 0;
+		while ( e < encoded.size() && encoded[e].first != base )
+		{
+			e++;
+		}
+		if ( e == encoded.size() )
+		{
+			encoded.emplace_back(base, ByteWriter());
+			encodeSpecFrame((base) ? &old : nullptr, frame, encoded.back().second);
+		}
+		const ByteWriter& message = encoded[e].second;
+		// a message bigger than a whole second's allowance still goes once the bucket is full, or the viewer would starve
+		if ( message.size() + 4 > viewer.tokens && viewer.tokens < m_rate )
+		{
+			m_skipped++;
+			m_viewers[kept++] = std::move(viewer);
+			continue;
+		}
+		viewer.tokens -= message.size() + 4;
+		writeMessage(viewer.pending, message);
+		viewer.base = frame.seq;
+		if ( !flush(viewer) )
+		{
+			::close(viewer.socket);
+			continue;
+		}
+		m_viewers[kept++] = std::move(viewer);
+	}
+	m_viewers.resize(kept);
+}
+
+void SpectatorServer::close()
+{
+	for (Viewer& viewer : m_viewers)
+	{
+		::close(viewer.socket);
+	}
+	m_viewers.clear();
+	if ( m_listen >= 0 )
+	{
+		::close(m_listen);
+	}
+	m_listen = -1;
+}
+
+bool SpectatorClient::connect(const char* address, uint16_t port)
+{
+	close();
+	sockaddr_in remote = {};
+	remote.sin_family = AF_INET;
+	remote.sin_port = htons(port);
+	if ( inet_pton(AF_INET, address, &remote.sin_addr) != 1 )
+	{
+		return false;
+	}
+	m_socket = socket(AF_INET, SOCK_STREAM, 0);
+	if ( m_socket < 0 )
+	{
+		return false;
+	}
+	if ( ::connect(m_socket, (sockaddr*)&remote, sizeof(remote)) < 0 )
+	{
+		close();
+		return false;
+	}
+	fcntl(m_socket, F_SETFL, O_NONBLOCK);
+	m_frame = SpecFrame();
+	m_in.clear();
+	m_hello = false;
+
+	return true;
+}
+
+bool SpectatorClient::poll()
+{
+	if ( m_socket < 0 )
+	{
+		return false;
+	}
+	uint8_t buffer[16384];
+	ssize_t got;
+	while ( (got = recv(m_socket, buffer, sizeof(buffer), 0)) > 0 )
+	{
+		m_in.insert(m_in.end(), buffer, buffer + got);
+		m_bytes += got;
+	}
+	bool closed = got == 0 || (got < 0 && errno != EAGAIN && errno != EWOULDBLOCK);
+	// the stream starts with the magic, then every message is its size and the frame
+	size_t pos = 0;
+	if ( !m_hello && m_in.size() >= 4 )
+	{
+		ByteReader magic(m_in.data(), 4);
+		if ( magic.u32() != SPECTATOR_MAGIC )
+		{
+			std::cout << "not a spectator stream" << std::endl;
+			close();
+			return false;
+		}
+		pos = 4;
+		m_hello = true;
+	}
+	bool fresh = false;
+	while ( m_in.size() - pos >= 4 )
+	{
+		ByteReader header(m_in.data() + pos, 4);
+		size_t size = header.u32();
+		if ( size > MAX_MESSAGE )
+		{
+			closed = true;
+			break;
+		}
+		if ( m_in.size() - pos - 4 < size )
+		{
+			break;
+		}
+		ByteReader in(m_in.data() + pos + 4, size);
+		if ( !decodeSpecFrame(in, m_frame) )
+		{
+			std::cout << "bad spectator frame" << std::endl;
+			closed = true;
+			break;
+		}
+		pos += 4 + size;
+		m_frames++;
+		fresh = true;
+	}
+	m_in.erase(m_in.begin(), m_in.begin() + pos);
+	if ( closed )
+	{
+		close();
+	}
+
+	return fresh;
+}
+
+void SpectatorClient::close()
+{
+	if ( m_socket >= 0 )
+	{
+		::close(m_socket);
+	}
+	m_socket = -1;
+}
+#endif
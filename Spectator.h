@@ -0,0 +1,118 @@
+#pragma once
+
+#include "Serialize.h"
+#include "Snapshot.h"
+#include <chrono>
+#include <vector>
+
+const uint32_t SPECTATOR_MAGIC = 0x56535753; // "SWSV"
+const size_t SPECTATOR_RATE = 256 * 1024; // default bytes per second per viewer
+const size_t SPECTATOR_HISTORY = 64; // frames kept to delta against
+
+enum SpecKind
+{
+	SPEC_SHAPE,
+	SPEC_LABEL
+};
+
+// every field of a drawable entity as spectators see it, quantized so unchanged entities delta to nothing
+enum SpecField
+{
+	SPEC_X, // quarter pixels
+	SPEC_Y,
+	SPEC_ROTATION, // 256ths of a turn
+	SPEC_SIDES,
+	SPEC_RADIUS, // quarter pixels
+	SPEC_OUTLINE_W,
+	SPEC_FILL, // palette index, labels keep their colour here
+	SPEC_FILL_ALPHA, // 16 steps
+	SPEC_OUTLINE,
+	SPEC_OUTLINE_ALPHA,
+	SPEC_TEXT, // labels, index into the game's label strings
+	SPEC_SIZE, // labels, font size
+	SPEC_FIELDS
+};
+
+struct SpecEntity
+{
+	uint32_t id; // game entities have the top bit set so they sort, and draw, after the background's
+	uint8_t kind;
+	int32_t fields[SPEC_FIELDS];
+};
+
+struct SpecFrame
+{
+	uint32_t seq = 0;
+	int32_t score = 0;
+	int32_t highScore = 0;
+	int32_t seconds = 0;
+	uint8_t background = 0; // palette index
+	std::vector< SpecEntity > entities; // in id order
+
+	void clear();
+	void addShape(uint32_t id, const Vector2& pos, float rotation, int sides, float radius, const Color& fill, const Color& outline, int outlineW);
+	void addLabel(uint32_t id, const Vector2& pos, int text, float size, const Color& colour);
+	void draw(RenderSnapshot& frame, const std::vector< const char* >& labels) const; // the viewer's side, labels are the game's strings
+};
+
+// fixed 256 colour palette: a 6x6x6 colour cube then 40 greys, so neither end has to send it
+uint8_t paletteIndex(const Color& colour);
+Color paletteColour(uint8_t index, uint8_t alpha = 15);
+
+// base is the frame the viewer already has, or null for a full frame
+void encodeSpecFrame(const SpecFrame* base, const SpecFrame& frame, ByteWriter& out);
+bool decodeSpecFrame(ByteReader& in, SpecFrame& frame); // frame holds the viewer's last frame and becomes the new one
+
+// streams frames to any number of viewers over TCP. Each viewer gets a delta against the last frame it was sent
+// in full, which TCP guarantees it has. A viewer that can't keep up, or would go over its byte rate, skips frames
+class SpectatorServer
+{
+private:
+	struct Viewer
+	{
+		int socket;
+		uint32_t base; // seq of the last frame it was sent, 0 before its first
+		std::vector< uint8_t > pending; // written but not yet taken by the socket
+		double tokens; // bytes it may still be sent
+	};
+	int m_listen = -1;
+	std::vector< Viewer > m_viewers;
+	std::vector< SpecFrame > m_history; // ring by seq
+	uint32_t m_seq = 0;
+	size_t m_rate = SPECTATOR_RATE;
+	std::chrono::steady_clock::time_point m_lastPublish;
+	size_t m_bytes = 0;
+	size_t m_skipped = 0;
+	void accept();
+	bool flush(Viewer& viewer);
+public:
+	~SpectatorServer();
+	bool listen(uint16_t port, size_t bytesPerSecond = SPECTATOR_RATE);
+	void publish(SpecFrame& frame); // assigns the frame its seq
+	void close();
+	size_t viewers() const;
+	size_t bytes() const;
+	size_t skipped() const; // frames held back from slow viewers
+	uint32_t frames() const;
+};
+
+// the viewer's end: reads the stream and keeps the latest frame
+class SpectatorClient
+{
+private:
+	int m_socket = -1;
+	std::vector< uint8_t > m_in;
+	bool m_hello = false; // the stream's magic has been checked
+	SpecFrame m_frame;
+	size_t m_bytes = 0;
+	size_t m_frames = 0;
+public:
+	~SpectatorClient();
+	bool connect(const char* address, uint16_t port);
+	bool poll(); // true when at least one new frame arrived
+	bool connected() const;
+	void close();
+	const SpecFrame& frame() const;
+	size_t bytes() const;
+	size_t frames() const;
+};
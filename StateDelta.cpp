@@ -0,0 +1,409 @@
+#include "StateDelta.h"
+#include <string.h>
+
+namespace
+{
+	const uint32_t DELTA_MAGIC = 0x44535753; // "SWSD"
+	const int ENTITY_WORDS = 24; // tag/flags/components word plus every component block
+	const int WORLD_WORDS = 18;
+
+	// what a list entry does between the two ticks, packed under the id gap
+	enum DeltaOp
+	{
+		OP_CHANGE = 0,
+		OP_FROM_ONLY = 1, // destroyed going forward, created going backward
+		OP_TO_ONLY = 2
+	};
+
+	void entityWords(const EntityState& s, uint32_t* words)
+	{
+		words[0] = s.tag | s.flags << 8 | s.components << 16;
+		int w = 1;
+		for (int c = 0; c < COMPONENT_COUNT; c++)
+		{
+			memcpy(words + w, componentWords(s, c), componentSize(c) * 4);
+			w += componentSize(c);
+		}
+	}
+
+	void setEntityWords(EntityState& s, const uint32_t* words)
+	{
+		s.tag = words[0];
+		s.flags = words[0] >> 8;
+		s.components = words[0] >> 16;
+		int w = 1;
+		for (int c = 0; c < COMPONENT_COUNT; c++)
+		{
+			memcpy(componentWords(s, c), words + w, componentSize(c) * 4);
+			w += componentSize(c);
+		}
+	}
+
+	void worldWords(const WorldState& s, uint64_t* words)
+	{
+		uint64_t values[WORLD_WORDS] = {
+			s.seed, (uint32_t)s.score, (uint32_t)s.highScore, (uint32_t)s.currentFrame, s.paused, s.player,
+			s.spawnRng.state, s.spawnRng.inc, s.labelRng.state, s.labelRng.inc,
+			(uint32_t)s.backCol.r | ((uint32_t)s.backCol.g << 8) | ((uint32_t)s.backCol.b << 16) | ((uint32_t)s.backCol.a << 24), s.backFrames, s.backIndex,
+			s.backRng.state, s.backRng.inc, s.world.total, s.back.total, s.player2
+		};
+		memcpy(words, values, sizeof(values));
+	}
+
+	void setWorldWords(WorldState& s, const uint64_t* words)
+	{
+		s.seed = words[0];
+		s.score = (int32_t)words[1];
+		s.highScore = (int32_t)words[2];
+		s.currentFrame = (int32_t)words[3];
+		s.paused = words[4];
+		s.player = words[5];
+		s.spawnRng = (RngState) {words[6], words[7]};
+		s.labelRng = (RngState) {words[8], words[9]};
+		s.backCol = (Color) {(unsigned char)words[10], (unsigned char)(words[10] >> 8), (unsigned char)(words[10] >> 16), (unsigned char)(words[10] >> 24)};
+		s.backFrames = words[11];
+		s.backIndex = words[12];
+		s.backRng = (RngState) {words[13], words[14]};
+		s.world.total = words[15];
+		s.back.total = words[16];
+		s.player2 = words[17];
+	}
+
+	// the full record, used for entities only one side has
+	void writeRecord(ByteWriter& out, const EntityState& s)
+	{
+		uint32_t words[ENTITY_WORDS];
+		entityWords(s, words);
+		out.u32(words[0]);
+		int w = 1;
+		for (int c = 0; c < COMPONENT_COUNT; c++)
+		{
+			if ( s.components & (1 << c) )
+			{
+				out.bytes(words + w, componentSize(c) * 4);
+			}
+			w += componentSize(c);
+		}
+	}
+
+	void readRecord(ByteReader& in, EntityState& s)
+	{
+		uint32_t words[ENTITY_WORDS] = {};
+		words[0] = in.u32();
+		uint8_t components = words[0] >> 16;
+		int w = 1;
+		for (int c = 0; c < COMPONENT_COUNT; c++)
+		{
+			if ( components & (1 << c) )
+			{
+				in.bytes(words + w, componentSize(c) * 4);
+			}
+			w += componentSize(c);
+		}
+		setEntityWords(s, words);
+	}
+
+	void encodeList(const EntityListState& from, const EntityListState& to, ByteWriter& out)
+	{
+		// both lists are in id order, walk them together. Ops are counted up front so they're written into a scratch buffer
+		ByteWriter ops;
+		size_t count = 0;
+		uint32_t lastId = 0;
+		size_t f = 0;
+		size_t t = 0;
+		uint32_t a[ENTITY_WORDS];
+		uint32_t b[ENTITY_WORDS];
+		while ( f < from.entities.size() || t < to.entities.size() )
+		{
+			const EntityState* fs = (f < from.entities.size()) ? &from.entities[f] : nullptr;
+			const EntityState* ts = (t < to.entities.size()) ? &to.entities[t] : nullptr;
+			if ( fs && ts && fs->id == ts->id )
+			{
+				entityWords(*fs, a);
+				entityWords(*ts, b);
+				uint32_t mask = 0;
+				for (int w = 0; w < ENTITY_WORDS; w++)
+				{
+					mask |= (uint32_t)(a[w] != b[w]) << w;
+				}
+				if ( mask )
+				{
+					ops.varint((uint64_t)(fs->id - lastId) << 2 | OP_CHANGE);
+					ops.varint(mask);
+					for (int w = 0; w < ENTITY_WORDS; w++)
+					{
+						if ( mask & (1 << w) )
+						{
+							ops.varint(a[w] ^ b[w]);
+						}
+					}
+					lastId = fs->id;
+					count++;
+				}
+				f++;
+				t++;
+			}
+			else if ( fs && (!ts || fs->id < ts->id) )
+			{
+				ops.varint((uint64_t)(fs->id - lastId) << 2 | OP_FROM_ONLY);
+				writeRecord(ops, *fs);
+				lastId = fs->id;
+				count++;
+				f++;
+			}
+			else
+			{
+				ops.varint((uint64_t)(ts->id - lastId) << 2 | OP_TO_ONLY);
+				writeRecord(ops, *ts);
+				lastId = ts->id;
+				count++;
+				t++;
+			}
+		}
+		out.varint(count);
+		out.bytes(ops.buffer(), ops.size());
+	}
+
+	bool applyList(EntityListState& list, ByteReader& in, bool forward)
+	{
+		size_t count = in.varint();
+		if ( count > in.remaining() )
+		{
+			return false;
+		}
+		// entries only the state we're heading to has get inserted, entries only the one we're leaving has get dropped
+		DeltaOp insert = (forward) ? OP_TO_ONLY : OP_FROM_ONLY;
+		std::vector< EntityState > result;
+		result.reserve(list.entities.size() + count);
+		size_t cursor = 0;
+		uint32_t id = 0;
+		uint32_t words[ENTITY_WORDS];
+		for (size_t i = 0; i < count && in.ok(); i++)
+		{
+			uint64_t key = in.varint();
+			id += key >> 2;
+			DeltaOp op = (DeltaOp)(key & 3);
+			while ( cursor < list.entities.size() && list.entities[cursor].id < id )
+			{
+				result.push_back(list.entities[cursor++]);
+			}
+			bool here = cursor < list.entities.size() && list.entities[cursor].id == id;
+			if ( op == OP_CHANGE )
+			{
+				if ( !here )
+				{
+					return false;
+				}
+				EntityState s = list.entities[cursor++];
+				entityWords(s, words);
+				uint32_t mask = in.varint();
+				for (int w = 0; w < ENTITY_WORDS; w++)
+				{
+					if ( mask & (1 << w) )
+					{
+						words[w] ^= in.varint();
+					}
+				}
+				setEntityWords(s, words);
+				result.push_back(s);
+			}
+			else if ( op == insert )
+			{
+				EntityState s;
+				s.id = id;
+				readRecord(in, s);
+				result.push_back(s);
+			}
+			else
+			{
+				if ( !here )
+				{
+					return false;
+				}
+				EntityState skipped;
+				readRecord(in, skipped);
+				cursor++;
+			}
+		}
+		while ( cursor < list.entities.size() )
+		{
+			result.push_back(list.entities[cursor++]);
+		}
+		list.entities.swap(result);
+
+		return in.ok();
+	}
+
+	void writeTags(ByteWriter& out, const std::vector< std::string >& tags)
+	{
+		out.varint(tags.size());
+		for (const std::string& tag : tags)
+		{
+			out.str(tag);
+		}
+	}
+
+	bool readTags(ByteReader& in, std::vector< std::string >& tags)
+	{
+		size_t count = in.varint();
+		if ( count > 256 )
+		{
+			return false;
+		}
+		tags.resize(count);
+		for (std::string& tag : tags)
+		{
+			tag = in.str();
+		}
+
+		return in.ok();
+	}
+}
+
+void encodeDelta(const WorldState& from, const WorldState& to, ByteWriter& out)
+{
+	out.u32(DELTA_MAGIC);
+	uint64_t a[WORLD_WORDS];
+	uint64_t b[WORLD_WORDS];
+	worldWords(from, a);
+	worldWords(to, b);
+	uint32_t mask = 0;
+	for (int w = 0; w < WORLD_WORDS; w++)
+	{
+		mask |= (uint32_t)(a[w] != b[w]) << w;
+	}
+	out.varint(mask);
+	for (int w = 0; w < WORLD_WORDS; w++)
+	{
+		if ( mask & (1 << w) )
+		{
+			out.varint(a[w] ^ b[w]);
+		}
+	}
+	// tag indices only mean something next to their table, so a delta between different tables carries both
+	bool tagsChanged = from.tags != to.tags;
+	out.u8(tagsChanged);
+	if ( tagsChanged )
+	{
+		writeTags(out, from.tags);
+		writeTags(out, to.tags);
+	}
+	encodeList(from.world, to.world, out);
+	encodeList(from.back, to.back, out);
+}
+
+bool applyDelta(WorldState& state, ByteReader& in, bool forward)
+{
+	if ( in.u32() != DELTA_MAGIC )
+	{
+		return false;
+	}
+	uint64_t words[WORLD_WORDS];
+	worldWords(state, words);
+	uint32_t mask = in.varint();
+	for (int w = 0; w < WORLD_WORDS; w++)
+	{
+		if ( mask & (1 << w) )
+		{
+			words[w] ^= in.varint();
+		}
+	}
+	setWorldWords(state, words);
+	if ( in.u8() )
+	{
+		std::vector< std::string > fromTags;
+		std::vector< std::string > toTags;
+		if ( !readTags(in, fromTags) || !readTags(in, toTags) )
+		{
+			return false;
+		}
+		state.tags = (forward) ? toTags : fromTags;
+	}
+
+	return applyList(state.world, in, forward) && applyList(state.back, in, forward);
+}
+
+StateHistory::StateHistory(size_t ticks)
+	: m_deltas(ticks)
+{
+}
+
+void StateHistory::push(const WorldState& state)
+{
+	if ( !m_empty && !m_deltas.empty() )
+	{
+		ByteWriter& delta = m_deltas[m_head];
+		delta.clear();
+		encodeDelta(m_latest, state, delta);
+		m_head = (m_head + 1) % m_deltas.size();
+		m_count = (m_count < m_deltas.size()) ? m_count + 1 : m_count;
+	}
+	m_latest = state;
+	m_empty = false;
+}
+
+bool StateHistory::rewind(size_t ticks, WorldState& out) const
+{
+	if ( m_empty || ticks > m_count )
+	{
+		return false;
+	}
+	out = m_latest;
+	for (size_t i = 1; i <= ticks; i++)
+	{
+		const ByteWriter& delta = m_deltas[(m_head + m_deltas.size() - i) % m_deltas.size()];
+		ByteReader in(delta.buffer(), delta.size());
+		if ( !applyDelta(out, in, false) )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void StateHistory::drop(size_t ticks)
+{
+	WorldState earlier;
+	if ( !rewind(ticks, earlier) )
+	{
+		clear();
+		return;
+	}
+	m_latest = earlier;
+	m_head = (m_head + m_deltas.size() - ticks) % m_deltas.size();
+	m_count -= ticks;
+}
+
+void StateHistory::clear()
+{
+	m_head = 0;
+	m_count = 0;
+	m_empty = true;
+}
+
+size_t StateHistory::size() const
+{
+	return m_count;
+}
+
+size_t StateHistory::capacity() const
+{
+	return m_deltas.size();
+}
+
+size_t StateHistory::bytes() const
+{
+	size_t total = 0;
+	for (size_t i = 1; i <= m_count; i++)
+	{
+		total += m_deltas[(m_head + m_deltas.size() - i) % m_deltas.size()].size();
+	}
+
+	return total;
+}
+
+const WorldState& StateHistory::latest() const
+{
+	return m_latest;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "SaveState.h"
+
+// difference between the world at two ticks. Changed fields are stored as XORs of their 32 bit words behind
+// a bitmask, and created or destroyed entities are stored whole, so the same delta steps forward from the
+// older state or backward from the newer one
+void encodeDelta(const WorldState& from, const WorldState& to, ByteWriter& out);
+bool applyDelta(WorldState& state, ByteReader& in, bool forward = true);
+
+// the last few seconds of a game as one full state plus a ring of per tick deltas, for rollback and scrubbing
+class StateHistory
+{
+private:
+	std::vector< ByteWriter > m_deltas; // m_deltas[i] steps from the tick before it to its own tick
+	size_t m_head = 0; // where the next delta goes
+	size_t m_count = 0;
+	WorldState m_latest;
+	bool m_empty = true;
+public:
+	StateHistory(size_t ticks = 120);
+	void push(const WorldState& state);
+	bool rewind(size_t ticks, WorldState& out) const; // out is the latest state stepped back that many ticks
+	void drop(size_t ticks); // forgets the newest ticks, so the history carries on from an earlier one
+	void clear();
+	size_t size() const; // ticks we can rewind
+	size_t capacity() const;
+	size_t bytes() const; // encoded size of the stored deltas
+	const WorldState& latest() const;
+};
@@ -0,0 +1,90 @@
+#include "TextCache.h"
+#include <stdio.h>
+
+bool CachedText::setText(const Font& font, const char* text, float size, float spacing)
+{
+	if ( m_fontId == font.texture.id && m_size == size && m_spacing == spacing && m_text == text )
+	{
+		return false;
+	}
+	m_text = text;
+	m_size = size;
+	m_spacing = spacing;
+	m_fontId = font.texture.id;
+	layout(font);
+	
+	return true;
+}
+
+bool CachedText::setValue(const Font& font, const char* prefix, int value, float size, float spacing)
+{
+	if ( m_prefix == prefix && m_value == value && m_fontId == font.texture.id && m_size == size && m_spacing == spacing )
+	{
+		return false;
+	}
+	char buffer[64];
+	snprintf(buffer, sizeof(buffer), "%s%d", prefix, value);
+	m_prefix = prefix;
+	m_value = value;
+	
+	return setText(font, buffer, size, spacing);
+}
+
+void CachedText::layout(const Font& font)
+{
+	// same placement rules as raylib's DrawTextEx so cached text looks identical
+	m_quads.clear();
+	float scaleFactor = m_size / font.baseSize;
+	float offsetX = 0;
+	float offsetY = 0;
+	float width = 0;
+	const char* text = m_text.c_str();
+	for (int i = 0; i < (int)m_text.size();)
+	{
+		int codepointBytes = 0;
+		int letter = GetNextCodepoint(&text[i], &codepointBytes);
+		int index = GetGlyphIndex(font, letter);
+		// NOTE: invalid UTF8 sequences are returned as '?' with a byte count of 0
+		if ( letter == 0x3f )
+		{
+			codepointBytes = 1;
+		}
+		i += codepointBytes;
+		if ( letter == '\n' )
+		{
+			offsetY += (int)((font.baseSize + font.baseSize / 2) * scaleFactor);
+			offsetX = 0;
+			continue;
+		}
+		if ( letter != ' ' )
+		{
+			Rectangle source = font.recs[index];
+			Rectangle dest = {offsetX + font.chars[index].offsetX * scaleFactor, offsetY + font.chars[index].offsetY * scaleFactor, source.width * scaleFactor, source.height * scaleFactor};
+			m_quads.push_back((GlyphQuad) {source, dest});
+		}
+		if ( font.chars[index].advanceX == 0 )
+		{
+			offsetX += ((float)font.recs[index].width * scaleFactor + m_spacing);
+		}
+		else
+		{
+			offsetX += ((float)font.chars[index].advanceX * scaleFactor + m_spacing);
+		}
+		width = (offsetX > width) ? offsetX : width;
+	}
+	bounds = (Vector2) {width, offsetY + font.baseSize * scaleFactor};
+}
+
+void CachedText::draw(const Font& font, const Vector2& pos, const Color& tint) const
+{
+	for (const GlyphQuad& quad : m_quads)
+	{
+		Rectangle dest = {pos.x + quad.dest.x, pos.y + quad.dest.y, quad.dest.width, quad.dest.height};
+		DrawTexturePro(font.texture, quad.source, dest, (Vector2) {0, 0}, 0.0f, tint);
+	}
+}
+
+const std::string& CachedText::text() const
+{
+	return m_text;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "raylib.h"
+#include <string>
+#include <vector>
+
+struct GlyphQuad
+{
+	Rectangle source; // glyph rectangle in the font atlas
+	Rectangle dest; // relative to the text origin
+};
+
+// text that is only formatted and laid out again when it actually changes. Drawing replays the cached glyph quads
+class CachedText
+{
+private:
+	std::string m_text;
+	std::vector< GlyphQuad > m_quads;
+	const char* m_prefix = nullptr;
+	int m_value = 0;
+	float m_size = 0;
+	float m_spacing = 0;
+	unsigned int m_fontId = 0;
+	void layout(const Font& font);
+public:
+	Vector2 bounds = {0, 0};
+	bool setText(const Font& font, const char* text, float size, float spacing);
+	bool setValue(const Font& font, const char* prefix, int value, float size, float spacing);
+	void draw(const Font& font, const Vector2& pos, const Color& tint) const;
+	const std::string& text() const;
+};
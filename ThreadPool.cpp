@@ -0,0 +1,79 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(size_t threads)
+{
+	if ( threads == 0 )
+	{
+		threads = std::thread::hardware_concurrency();
+	}
+	// the caller counts as one of the threads
+	for (size_t i = 1; i < threads; i++)
+	{
+		m_workers.emplace_back(&ThreadPool::worker, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_quit = true;
+	}
+	m_wake.notify_all();
+	for (auto& t : m_workers)
+	{
+		t.join();
+	}
+}
+
+void ThreadPool::worker()
+{
+	size_t seen = 0;
+	std::unique_lock<std::mutex> lock(m_lock);
+	while ( true )
+	{
+		m_wake.wait(lock, [&] { return m_quit || m_generation != seen; });
+		if ( m_quit )
+		{
+			break;
+		}
+		seen = m_generation;
+		lock.unlock();
+		work();
+		lock.lock();
+		if ( ++m_finished == m_workers.size() )
+		{
+			m_done.notify_all();
+		}
+	}
+}
+
+void ThreadPool::work()
+{
+	size_t i;
+	while ( (i = m_next.fetch_add(1)) < m_count )
+	{
+		m_job(i);
+	}
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function< void(size_t) >& job)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_job = job;
+		m_count = count;
+		m_next = 0;
+		m_finished = 0;
+		m_generation++;
+	}
+	m_wake.notify_all();
+	work();
+	std::unique_lock<std::mutex> lock(m_lock);
+	m_done.wait(lock, [&] { return m_finished == m_workers.size(); });
+}
+
+size_t ThreadPool::size() const
+{
+	return m_workers.size() + 1;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+
+// fixed set of worker threads that split an index range between them. The calling thread helps out and
+// parallelFor only returns once every index has been run
+class ThreadPool
+{
+private:
+	std::vector< std::thread > m_workers;
+	std::mutex m_lock;
+	std::condition_variable m_wake;
+	std::condition_variable m_done;
+	std::function< void(size_t) > m_job;
+	std::atomic< size_t > m_next{0};
+	size_t m_count = 0;
+	size_t m_finished = 0;
+	size_t m_generation = 0;
+	bool m_quit = false;
+	void worker();
+	void work();
+public:
+	ThreadPool(size_t threads = 0); // 0 uses one thread per hardware thread, including the caller
+	~ThreadPool();
+	void parallelFor(size_t count, const std::function< void(size_t) >& job);
+	size_t size() const;
+};
@@ -0,0 +1,123 @@
+#include "Trace.h"
+#include <stdio.h>
+#include <inttypes.h>
+
+namespace
+{
+	const uint32_t MAX_NAMED_THREADS = 64;
+	std::atomic< uint32_t > nextThread{0};
+	std::atomic< const char* > threadNames[MAX_NAMED_THREADS];
+}
+
+uint32_t traceThread()
+{
+	thread_local uint32_t id = nextThread++;
+	return id;
+}
+
+void nameTraceThread(const char* name)
+{
+	uint32_t id = traceThread();
+	if ( id < MAX_NAMED_THREADS )
+	{
+		threadNames[id] = name;
+	}
+}
+
+TraceBuffer::TraceBuffer(size_t capacity)
+	: m_events(new TraceEvent[(capacity) ? capacity : 1]), m_capacity((capacity) ? capacity : 1), m_epoch(std::chrono::steady_clock::now())
+{
+}
+
+TraceEvent& TraceBuffer::claim(uint64_t& index)
+{
+	index = m_next.fetch_add(1, std::memory_order_relaxed);
+	TraceEvent& event = m_events[index % m_capacity];
+	event.stamp.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	event.thread = traceThread();
+
+	return event;
+}
+
+void TraceBuffer::span(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+	uint64_t index;
+	TraceEvent& event = claim(index);
+	event.start = std::chrono::duration_cast< std::chrono::nanoseconds >(start - m_epoch).count();
+	event.duration = std::chrono::duration_cast< std::chrono::nanoseconds >(end - start).count();
+	event.name = name;
+	event.series = nullptr;
+	event.value = 0;
+	event.kind = TRACE_SPAN;
+	event.stamp.store(index + 1, std::memory_order_release);
+}
+
+void TraceBuffer::counter(const char* name, const char* series, int64_t value)
+{
+	uint64_t index;
+	TraceEvent& event = claim(index);
+	event.start = std::chrono::duration_cast< std::chrono::nanoseconds >(std::chrono::steady_clock::now() - m_epoch).count();
+	event.duration = 0;
+	event.name = name;
+	event.series = series;
+	event.value = value;
+	event.kind = TRACE_COUNTER;
+	event.stamp.store(index + 1, std::memory_order_release);
+}
+
+bool TraceBuffer::write(const char* file) const
+{
+	FILE* out = fopen(file, "wb");
+	if ( !out )
+	{
+		return false;
+	}
+	fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	bool first = true;
+	for (uint32_t t = 0; t < nextThread && t < MAX_NAMED_THREADS; t++)
+	{
+		const char* name = threadNames[t];
+		if ( name )
+		{
+			fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", (first) ? "" : ",\n", t, name);
+			first = false;
+		}
+	}
+	// oldest surviving event first, so the file is roughly in time order
+	uint64_t end = m_next.load(std::memory_order_acquire);
+	uint64_t begin = (end > m_capacity) ? end - m_capacity : 0;
+	for (uint64_t i = begin; i < end; i++)
+	{
+		const TraceEvent& event = m_events[i % m_capacity];
+		if ( event.stamp.load(std::memory_order_acquire) != i + 1 )
+		{
+			continue;
+		}
+		if ( event.kind == TRACE_SPAN )
+		{
+			fprintf(out, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", (first) ? "" : ",\n", event.name, event.thread, event.start / 1e3, event.duration / 1e3);
+		}
+		else
+		{
+			// each series is its own counter track, an event that left one out would read as it dropping to zero
+			fprintf(out, "%s{\"name\":\"%s%s%s\",\"ph\":\"C\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"args\":{\"value\":%" PRId64 "}}", (first) ? "" : ",\n", event.name, (event.series) ? " " : "", (event.series) ? event.series : "", event.thread, event.start / 1e3, event.value);
+		}
+		first = false;
+	}
+	fprintf(out, "\n]}\n");
+	fclose(out);
+
+	return true;
+}
+
+size_t TraceBuffer::size() const
+{
+	uint64_t written = m_next.load(std::memory_order_relaxed);
+	return (written < m_capacity) ? written : m_capacity;
+}
+
+size_t TraceBuffer::capacity() const
+{
+	return m_capacity;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdint.h>
+#include <stddef.h>
+
+enum TraceKind
+{
+	TRACE_SPAN,
+	TRACE_COUNTER
+};
+
+// one slot of the ring. stamp is 0 while it's being written and the event's index + 1 once it's complete
+struct TraceEvent
+{
+	std::atomic< uint64_t > stamp{0};
+	uint64_t start; // nanoseconds since the buffer was made
+	uint64_t duration;
+	const char* name; // names and series must be string literals, they're kept by pointer
+	const char* series; // counters only, appended to the name so one counter can be broken down, by tag say
+	int64_t value;
+	uint32_t thread;
+	uint8_t kind;
+};
+
+// the last few seconds of spans and counters, written from any thread without locks or I/O. When it's full the
+// oldest events are overwritten. write() turns what's left into Chrome trace event JSON for chrome://tracing or Perfetto
+class TraceBuffer
+{
+private:
+	std::unique_ptr< TraceEvent[] > m_events;
+	size_t m_capacity;
+	std::atomic< uint64_t > m_next{0};
+	std::chrono::steady_clock::time_point m_epoch;
+	TraceEvent& claim(uint64_t& index);
+public:
+	TraceBuffer(size_t capacity);
+	void span(const char* name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+	void counter(const char* name, const char* series, int64_t value);
+	bool write(const char* file) const; // call once writers are quiet, events mid-write are skipped
+	size_t size() const;
+	size_t capacity() const;
+};
+
+// small stable ids for threads in the trace, the name shows up in the viewer. Call nameTraceThread on the thread itself
+uint32_t traceThread();
+void nameTraceThread(const char* name);
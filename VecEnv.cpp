@@ -0,0 +1,101 @@
+#include "VecEnv.h"
+
+VecEnv::VecEnv(const char* confile, size_t count, uint64_t seed, size_t threads, const ObsConfig& obs)
+	: m_scores(count), m_deaths(count), m_encoders(count, ObservationEncoder(obs)), m_obs(count * ObservationEncoder(obs).size()), m_rewards(count), m_dones(count), m_pool(threads)
+{
+	for (size_t i = 0; i < count; i++)
+	{
+		m_games.push_back(std::make_unique< Game >(confile, true, seed + i));
+	}
+	// a few contiguous blocks per thread keeps the pool's shared counter and the output arrays out of each other's way
+	m_chunk = count / (m_pool.size() * 4);
+	m_chunk = (m_chunk) ? m_chunk : 1;
+	for (size_t i = 0; i < count; i++)
+	{
+		observe(i);
+	}
+}
+
+void VecEnv::reset(uint64_t seed)
+{
+	for (size_t i = 0; i < m_games.size(); i++)
+	{
+		m_games[i]->reset(seed + i);
+		m_scores[i] = 0;
+		m_deaths[i] = 0;
+		m_rewards[i] = 0;
+		m_dones[i] = 0;
+		observe(i);
+	}
+}
+
+void VecEnv::step(const InputFrame* actions)
+{
+	size_t chunks = (m_games.size() + m_chunk - 1) / m_chunk;
+	m_pool.parallelFor(chunks, [&](size_t chunk)
+	{
+		size_t end = std::min((chunk + 1) * m_chunk, m_games.size());
+		for (size_t i = chunk * m_chunk; i < end; i++)
+		{
+			stepEnv(i, actions[i]);
+		}
+	});
+}
+
+void VecEnv::stepEnv(size_t env, const InputFrame& action)
+{
+	Game& game = *m_games[env];
+	InputFrame input = action;
+	input.buttons &= ~INPUT_PAUSE; // agents don't get to pause
+	game.sInput(input);
+	game.simulate();
+	if ( game.m_deaths != m_deaths[env] )
+	{
+		// the respawn already zeroed the score, so reward what the finished run got up to
+		m_rewards[env] = game.m_lastScore - m_scores[env];
+		m_dones[env] = 1;
+		m_deaths[env] = game.m_deaths;
+	}
+	else
+	{
+		m_rewards[env] = game.m_score - m_scores[env];
+		m_dones[env] = 0;
+	}
+	m_scores[env] = game.m_score;
+	observe(env);
+}
+
+void VecEnv::observe(size_t env)
+{
+	m_encoders[env].encode(*m_games[env], &m_obs[env * obsSize()]);
+}
+
+size_t VecEnv::size() const
+{
+	return m_games.size();
+}
+
+size_t VecEnv::obsSize() const
+{
+	return (m_encoders.empty()) ? 0 : m_encoders.front().size();
+}
+
+const float* VecEnv::observations() const
+{
+	return m_obs.data();
+}
+
+const float* VecEnv::rewards() const
+{
+	return m_rewards.data();
+}
+
+const uint8_t* VecEnv::dones() const
+{
+	return m_dones.data();
+}
+
+const Game& VecEnv::game(size_t env) const
+{
+	return *m_games[env];
+}
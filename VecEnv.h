@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Game.h"
+#include "ObservationEncoder.h"
+#include "ThreadPool.h"
+#include <memory>
+
+// steps many independent headless games in lockstep across a thread pool, for training agents.
+// Every array is env-major: env i owns rewards()[i], dones()[i] and obsSize() floats starting at observations() + i * obsSize().
+// A game that ends respawns straight away, so its next observation is already the start of a new run
+class VecEnv
+{
+private:
+	std::vector< std::unique_ptr< Game > > m_games;
+	std::vector< int > m_scores; // score after the previous step
+	std::vector< int > m_deaths;
+	std::vector< ObservationEncoder > m_encoders; // one per game so threads never share scratch space
+	std::vector< float > m_obs;
+	std::vector< float > m_rewards;
+	std::vector< uint8_t > m_dones;
+	ThreadPool m_pool;
+	size_t m_chunk = 1; // games per pool job
+	void stepEnv(size_t env, const InputFrame& action);
+	void observe(size_t env);
+public:
+	VecEnv(const char* confile, size_t count, uint64_t seed, size_t threads = 0, const ObsConfig& obs = ObsConfig());
+	void reset(uint64_t seed); // env i is seeded with seed + i
+	void step(const InputFrame* actions); // one action per env
+	size_t size() const;
+	size_t obsSize() const;
+	const float* observations() const;
+	const float* rewards() const; // score gained this step
+	const uint8_t* dones() const; // 1 if the player died this step
+	const Game& game(size_t env) const;
+};
@@ -1,29 +1,412 @@
 #include "Game.h"
+#include "VecEnv.h"
+#include "SoftwareRenderer.h"
 #include <iostream>
+#include <chrono>
+#include <string.h>
+
+struct Options
+{
+	const char* config = "config.json";
+	bool headless = false;
+	long ticks = 0; // headless only, 0 runs until killed
+	uint64_t seed = 0; // 0 uses the config file's seed, or the clock
+	const char* record = nullptr; // input log to write
+	const char* replay = nullptr; // input log to play back instead of reading the keyboard
+	const char* load = nullptr; // save state to start from
+	const char* save = nullptr; // save state to write on exit
+	int speed = 1; // ticks simulated per presented frame
+	int host = 0; // UDP port to host a two player game on
+	const char* join = nullptr; // address:port of a two player game to join
+	int bot = -1; // milliseconds of delay for a loopback bot playing the second player, -1 for none
+	long envs = 0; // games stepped in lockstep by random agents, implies headless
+	int spectate = 0; // TCP port to stream the game to spectators on
+	const char* watch = nullptr; // address:port of a game to spectate
+	const char* trace = nullptr; // Chrome trace to write on exit
+	int traceSeconds = 10;
+	int metrics = 0; // localhost port to serve Prometheus metrics on
+	bool counters = false; // hardware counters per system
+	const char* hitches = nullptr; // directory to capture frames over budget to
+	double hitchBudget = 1.5; // times the fps period
+	const char* scenario = nullptr; // stress scenario to run headless, see scenarios/
+	float scale = 1; // multiplies the scenario's entity counts
+	const char* frames = nullptr; // directory to write software rendered frames to, implies headless
+	long frameEvery = 1; // ticks between written frames
+};
+
+Options parse_args(int argc, char* argv[])
+{
+	Options opts;
+	for (int i = 1; i < argc; i++)
+	{
+		if ( strcmp(argv[i], "--headless") == 0 )
+		{
+			opts.headless = true;
+		}
+		else if ( strcmp(argv[i], "--ticks") == 0 && i + 1 < argc )
+		{
+			opts.ticks = atol(argv[++i]);
+		}
+		else if ( strcmp(argv[i], "--seed") == 0 && i + 1 < argc )
+		{
+			opts.seed = strtoull(argv[++i], nullptr, 10);
+		}
+		else if ( strcmp(argv[i], "--record") == 0 && i + 1 < argc )
+		{
+			opts.record = argv[++i];
+		}
+		else if ( strcmp(argv[i], "--replay") == 0 && i + 1 < argc )
+		{
+			opts.replay = argv[++i];
+		}
+		else if ( strcmp(argv[i], "--load") == 0 && i + 1 < argc )
+		{
+			opts.load = argv[++i];
+		}
+		else if ( strcmp(argv[i], "--save") == 0 && i + 1 < argc )
+		{
+			opts.save = argv[++i];
+		}
+		else if ( strcmp(argv[i], "--speed") == 0 && i + 1 < argc )
+		{
+			opts.speed = atoi(argv[++i]);
+		}
+		else if ( strcmp(argv[i], "--host") == 0 && i + 1 < argc )
+		{
+			opts.host = atoi(argv[++i]);
+		}
+		else if ( strcmp(argv[i], "--join") == 0 && i + 1 < argc )
+		{
+			opts.join = argv[++i];
+		}
+		else if ( strcmp(argv[i], "--loopback-bot") == 0 && i + 1 < argc )
+		{
+			opts.bot = atoi(argv[++i]);
+		}
+		else if ( strcmp(argv[i], "--spectate") == 0 && i + 1 < argc )
+		{
+			opts.spectate = atoi(argv[++i]);
+		}
+		else if ( strcmp(argv[i], "--watch") == 0 && i + 1 < argc )
+		{
+			opts.watch = argv[++i];
+		}
+		else if ( strcmp(argv[i], "--trace") == 0 && i + 1 < argc )
+		{
+			opts.trace = argv[++i];
+		}
+		else if ( strcmp(argv[i], "--trace-seconds") == 0 && i + 1 < argc )
+		{
+			opts.traceSeconds = atoi(argv[++i]);
+		}
+		else if ( strcmp(argv[i], "--metrics") == 0 && i + 1 < argc )
+		{
+			opts.metrics = atoi(argv[++i]);
+		}
+		else if ( strcmp(argv[i], "--counters") == 0 )
+		{
+			opts.counters = true;
+		}
+		else if ( strcmp(argv[i], "--hitches") == 0 && i + 1 < argc )
+		{
+			opts.hitches = argv[++i];
+		}
+		else if ( strcmp(argv[i], "--hitch-budget") == 0 && i + 1 < argc )
+		{
+			opts.hitchBudget = atof(argv[++i]);
+		}
+		else if ( strcmp(argv[i], "--scenario") == 0 && i + 1 < argc )
+		{
+			opts.scenario = argv[++i];
+			opts.headless = true;
+		}
+		else if ( strcmp(argv[i], "--scale") == 0 && i + 1 < argc )
+		{
+			opts.scale = atof(argv[++i]);
+		}
+		else if ( strcmp(argv[i], "--frames") == 0 && i + 1 < argc )
+		{
+			opts.frames = argv[++i];
+			opts.headless = true;
+		}
+		else if ( strcmp(argv[i], "--frame-every") == 0 && i + 1 < argc )
+		{
+			opts.frameEvery = atol(argv[++i]);
+			opts.frameEvery = (opts.frameEvery > 0) ? opts.frameEvery : 1;
+		}
+		else if ( strcmp(argv[i], "--envs") == 0 && i + 1 < argc )
+		{
+			opts.envs = atol(argv[++i]);
+		}
+		else if ( strcmp(argv[i], "--config") == 0 && i + 1 < argc )
+		{
+			opts.config = argv[++i];
+		}
+		else
+		{
+			std::cout << "unknown option " << argv[i] << std::endl;
+			std::cout << "usage: shape_wars [--config file] [--seed n] [--record file] [--replay file] [--load file] [--save file] [--speed n] [--host port [--loopback-bot ms]] [--join address:port] [--spectate port] [--watch address:port] [--trace file [--trace-seconds n]] [--metrics port] [--counters] [--hitches dir [--hitch-budget x]] [--headless [--ticks n]] [--scenario file [--scale x] [--ticks n]] [--frames dir [--frame-every n]] [--envs n [--ticks n]]" << std::endl;
+		}
+	}
+
+	return opts;
+}
+
+// address:port, or just :port for this machine
+void split_address(const char* text, std::string& address, uint16_t& port)
+{
+	address = text;
+	size_t colon = address.rfind(':');
+	port = atoi(address.substr(colon + 1).c_str());
+	address = (colon == std::string::npos || colon == 0) ? "127.0.0.1" : address.substr(0, colon);
+}
 
 // hack for web
-// TODO: pass in the name of the config file as argv to main function
-Game g("config.json");
+Game* g = nullptr;
 void main_loop()
 {
-  g.run();
+  g->run();
+}
+
+void report_speed(size_t ticks, double seconds, int fps)
+{
+	std::cout << "simulated " << ticks << " ticks in " << seconds << "s (" << ticks / seconds << " ticks/s, " << ticks / seconds / fps << "x real time)" << std::endl;
+}
+
+int run_headless(const Options& opts)
+{
+	std::cout << "running headless" << std::endl;
+	auto start = std::chrono::steady_clock::now();
+	long ticks = 0;
+	size_t peak = 0;
+	// frames are drawn on the CPU, there's no window to draw them in
+	std::unique_ptr< SoftwareRenderer > renderer;
+	if ( opts.frames )
+	{
+		const GameConfig& config = g->getConfig();
+		renderer = std::make_unique< SoftwareRenderer >(config.window.width, config.window.height, config.font.size, config.font.col);
+		std::error_code error;
+		std::filesystem::create_directories(opts.frames, error);
+	}
+	while ( opts.ticks == 0 || ticks < opts.ticks )
+	{
+		g->run();
+		if ( g->replayFinished() )
+		{
+			break;
+		}
+		if ( opts.scenario )
+		{
+			peak = std::max(peak, g->entityCount());
+		}
+		if ( renderer && ticks % opts.frameEvery == 0 )
+		{
+			char file[32];
+			snprintf(file, sizeof(file), "frame-%06ld.ppm", ticks);
+			std::string path = (std::filesystem::path(opts.frames) / file).string();
+			g->draw(*renderer);
+			if ( !renderer->savePPM(path.c_str()) )
+			{
+				std::cout << "could not write frame " << path << std::endl;
+				return 1;
+			}
+		}
+		ticks++;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	logFlush();
+	report_speed(ticks, seconds, g->getConfig().window.fps);
+	if ( opts.scenario )
+	{
+		std::cout << "peak of " << peak << " entities, " << g->entityCount() << " left" << std::endl;
+#if !defined(SW_PROFILE)
+		std::cout << "per system timings need a build with PROFILE=TRUE" << std::endl;
+#endif
+	}
+	std::cout << "seed " << g->seed() << ", final score " << g->score() << " on frame " << g->currentFrame() << std::endl;
+
+	return 0;
 }
 
-int main()
+// throughput check for the training environment, every game gets random buttons each tick
+int run_envs(const Options& opts)
 {
+	uint64_t seed = (opts.seed) ? opts.seed : (uint64_t)time(NULL);
+	VecEnv env(opts.config, opts.envs, seed);
+	std::vector< InputFrame > actions(env.size());
+	Rng agent(seed, 0);
+	long episodes = 0;
+	double reward = 0;
+	std::cout << "stepping " << env.size() << " games" << std::endl;
+	auto start = std::chrono::steady_clock::now();
+	long ticks = 0;
+	while ( opts.ticks == 0 || ticks < opts.ticks )
+	{
+		for (auto& action : actions)
+		{
+			action.buttons = agent.next();
+			action.mouseX = agent.range(0, 1279);
+			action.mouseY = agent.range(0, 719);
+		}
+		env.step(actions.data());
+		for (size_t i = 0; i < env.size(); i++)
+		{
+			episodes += env.dones()[i];
+			reward += env.rewards()[i];
+		}
+		ticks++;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "simulated " << ticks * env.size() << " env steps in " << seconds << "s (" << ticks * env.size() / seconds << " steps/s)" << std::endl;
+	std::cout << episodes << " episodes ended, " << reward << " total reward" << std::endl;
+	
+	return 0;
+}
+
+int main(int argc, char* argv[])
+{
+	Options opts = parse_args(argc, argv);
+	if ( opts.envs > 0 )
+	{
+		return run_envs(opts);
+	}
 	std::cout << "initializing game" << std::endl;
+	g = new Game(opts.config, opts.headless, opts.seed);
+	if ( opts.replay && !g->replay(opts.replay) )
+	{
+		delete g;
+		return 1;
+	}
+	if ( opts.load && !g->loadState(opts.load) )
+	{
+		delete g;
+		return 1;
+	}
+	if ( opts.record )
+	{
+		g->record(opts.record);
+	}
+	if ( opts.scenario )
+	{
+		ScenarioConfig scenario;
+		if ( !parse_scenario(scenario, opts.scenario, opts.scale) )
+		{
+			std::cout << "could not read scenario " << opts.scenario << std::endl;
+			delete g;
+			return 1;
+		}
+		g->loadScenario(scenario);
+		opts.ticks = (opts.ticks) ? opts.ticks : scenario.ticks;
+	}
+	g->setSpeed(opts.speed);
+	if ( opts.trace )
+	{
+		g->trace(opts.trace, opts.traceSeconds);
+	}
+	if ( opts.counters )
+	{
+		g->counters();
+	}
+	if ( opts.hitches )
+	{
+		g->hitches(opts.hitches, opts.hitchBudget, opts.traceSeconds);
+	}
+#if !defined(PLATFORM_WEB)
+	std::unique_ptr< LoopbackBot > bot;
+	if ( opts.host && !g->host(opts.host) )
+	{
+		delete g;
+		return 1;
+	}
+	if ( opts.host && opts.bot >= 0 )
+	{
+		bot = std::make_unique< LoopbackBot >(opts.host, g->getConfig().window.fps, opts.bot / 1000.0);
+		bot->start();
+	}
+	std::string address;
+	uint16_t port;
+	if ( opts.join )
+	{
+		split_address(opts.join, address, port);
+		if ( !g->join(address.c_str(), port) )
+		{
+			delete g;
+			return 1;
+		}
+	}
+	if ( opts.spectate && !g->spectate(opts.spectate) )
+	{
+		delete g;
+		return 1;
+	}
+	if ( opts.metrics && !g->metrics(opts.metrics) )
+	{
+		delete g;
+		return 1;
+	}
+	if ( opts.watch )
+	{
+		split_address(opts.watch, address, port);
+		if ( !g->watch(address.c_str(), port) )
+		{
+			delete g;
+			return 1;
+		}
+	}
+#endif
+	if ( opts.headless )
+	{
+		int result = run_headless(opts);
+#if !defined(PLATFORM_WEB)
+		if ( bot )
+		{
+			bot->stop();
+		}
+#endif
+		if ( opts.save )
+		{
+			g->saveState(opts.save);
+		}
+		g->cleanup();
+		delete g;
+
+		return result;
+	}
 #if defined(PLATFORM_WEB)
 	std::cout << "running for web" << std::endl;
 	// TODO: fix game logic so that framerate doesn't have to be fixed
     emscripten_set_main_loop(main_loop, 60, 1);
 #else
 	std::cout << "running for desktop" << std::endl;
+	auto start = std::chrono::steady_clock::now();
+	auto lastReport = start;
     while (!WindowShouldClose())
     {
-        g.run();
+        g->run();
+		// fast forwarding reports how it's keeping up every few seconds
+		auto now = std::chrono::steady_clock::now();
+		if ( g->speed() > 1 && now - lastReport > std::chrono::seconds(5) )
+		{
+			report_speed(g->ticks(), std::chrono::duration<double>(now - start).count(), g->getConfig().window.fps);
+			lastReport = now;
+		}
     }
+	logFlush();
+	report_speed(g->ticks(), std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), g->getConfig().window.fps);
+#endif
+	std::cout << "seed " << g->seed() << ", final score " << g->score() << " on frame " << g->currentFrame() << std::endl;
+#if !defined(PLATFORM_WEB)
+	if ( bot )
+	{
+		bot->stop();
+	}
 #endif
-	g.cleanup();
+	if ( opts.save )
+	{
+		g->saveState(opts.save);
+	}
+	g->cleanup();
+	delete g;
 	CloseWindow();
 	return 0;
 }
@@ -0,0 +1,104 @@
+#include "Test.h"
+#include "GameTests.h"
+#include <new>
+#include <stdint.h>
+#include <thread>
+
+// a frame's scope is on the main thread while windowed games run its systems on the simulation thread, so what a
+// system allocates over there must still show in the frame's total
+TEST(frame_counts_allocations_on_other_threads)
+{
+	const int ALLOCS = 100;
+	Profiler profiler;
+	{
+		ProfileScope frame(profiler, PROF_FRAME);
+		std::thread simulation([&]()
+		{
+			ProfileScope system(profiler, PROF_UPDATE);
+			std::vector< int* > blocks;
+			blocks.reserve(ALLOCS);
+			for (int i = 0; i < ALLOCS; i++)
+			{
+				blocks.push_back(new int(i));
+			}
+			for (int* block : blocks)
+			{
+				delete block;
+			}
+		});
+		simulation.join();
+	}
+	ProfStats system = profiler.stats(PROF_UPDATE);
+	ProfStats frame = profiler.stats(PROF_FRAME);
+	CHECK(system.samples == 1 && frame.samples == 1);
+	CHECK(system.allocs == ALLOCS + 1);
+	CHECK(system.allocBytes >= ALLOCS * sizeof(int));
+	CHECK(frame.allocs >= system.allocs);
+	CHECK(frame.allocBytes >= system.allocBytes);
+}
+
+// the zero allocations in steady state gate: once a busy world has settled, the systems that only touch what's
+// already there allocate nothing, and neither does capturing and encoding the world into reused buffers
+TEST(steady_state_systems_do_not_allocate)
+{
+	Game game("config.json", true, 3);
+	ScenarioConfig scenario;
+	CHECK(parse_scenario(scenario, "scenarios/bouncing.json", 0.1f));
+	game.loadScenario(scenario);
+	WorldState state;
+	ByteWriter out;
+	for (size_t i = 0; i < 300; i++)
+	{
+		game.run();
+		game.captureState(state);
+		out.clear();
+		encodeWorld(state, out);
+	}
+	AllocCounts before = threadAllocs();
+	// a full window, so the profiler's averages only cover settled ticks
+	for (size_t i = 0; i < PROFILE_WINDOW; i++)
+	{
+		game.run();
+	}
+	CHECK(game.entityCount() > 100);
+	AllocCounts ticks = threadAllocs();
+	CHECK(ticks.allocs > before.allocs); // EntityManager::update still allocates, so the counting is on
+	const ProfSystem settled[] = {PROF_MOVE, PROF_DURATION, PROF_TRANSFORM, PROF_SNAPSHOT};
+	for (ProfSystem system : settled)
+	{
+		ProfStats stats = GameTests::profiler(game).stats(system);
+		CHECK(stats.samples == PROFILE_WINDOW);
+		if ( stats.allocs != 0 )
+		{
+			std::cout << "    " << profSystemNames[system] << " allocates " << stats.allocs << " times a tick" << std::endl;
+		}
+		CHECK(stats.allocs == 0);
+	}
+	before = threadAllocs();
+	for (size_t i = 0; i < PROFILE_WINDOW; i++)
+	{
+		game.captureState(state);
+		out.clear();
+		encodeWorld(state, out);
+	}
+	CHECK(threadAllocs().allocs == before.allocs);
+	game.cleanup();
+}
+
+// the counting operator new adds a header to every block, which mustn't wrap a huge size around to a small block
+TEST(huge_allocations_fail)
+{
+	volatile size_t huge = SIZE_MAX - 1; // not a constant, so the compiler doesn't warn about it
+	bool threw = false;
+	try
+	{
+		void* ptr = operator new(huge);
+		operator delete(ptr);
+	}
+	catch ( const std::bad_alloc& )
+	{
+		threw = true;
+	}
+	CHECK(threw);
+	CHECK(operator new(huge, std::nothrow) == nullptr);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "../Game.h"
+
+// reaches into Game for the tests that need more than its public interface
+class GameTests
+{
+public:
+	// steps a two player game with our input, waiting on the other player like a headless run() does
+	static void netStep(Game& game, const InputFrame& local)
+	{
+		while ( !game.netStep(local) )
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+
+	static Profiler& profiler(Game& game)
+	{
+		return game.m_profiler;
+	}
+
+	static size_t netTick(const Game& game)
+	{
+		return game.m_netTick;
+	}
+
+	static size_t rollbacks(const Game& game)
+	{
+		return game.m_rollbacks;
+	}
+
+	static NetSession& session(Game& game)
+	{
+		return *game.m_net;
+	}
+
+	// the world as it was after tick, if the rollback history still reaches back that far
+	static bool netState(const Game& game, size_t tick, WorldState& state)
+	{
+		return tick <= game.m_netTick && game.m_netHistory.rewind(game.m_netTick - tick, state);
+	}
+
+	// a two player game like startNet() sets up, without a network. Both players' input comes from step()
+	static void startLocal(Game& game, uint64_t seed)
+	{
+		game.m_twoPlayer = true;
+		game.reset(seed);
+		game.back.entities.clear();
+		game.setPause(false);
+		game.m_menu = false;
+	}
+
+	static void step(Game& game, const InputFrame& first, const InputFrame& second)
+	{
+		game.sInput(first);
+		game.sInput2(second);
+		game.simulate();
+	}
+};
@@ -0,0 +1,220 @@
+#include "Test.h"
+#include "GameTests.h"
+#include <map>
+#include <sstream>
+#include <thread>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+namespace
+{
+	// what a scraper does: one GET over a fresh connection, read until the server closes it
+	bool scrape(uint16_t port, const char* path, std::string& response)
+	{
+		int socket = ::socket(AF_INET, SOCK_STREAM, 0);
+		if ( socket < 0 )
+		{
+			return false;
+		}
+		sockaddr_in server = {};
+		server.sin_family = AF_INET;
+		server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		server.sin_port = htons(port);
+		if ( connect(socket, (sockaddr*)&server, sizeof(server)) < 0 )
+		{
+			::close(socket);
+			return false;
+		}
+		std::string request = std::string("GET ") + path + " HTTP/1.1\r\nHost: 127.0.0.1\r\nAccept: text/plain\r\n\r\n";
+		send(socket, request.data(), request.size(), MSG_NOSIGNAL);
+		response.clear();
+		char buffer[4096];
+		ssize_t got;
+		while ( (got = recv(socket, buffer, sizeof(buffer), 0)) > 0 )
+		{
+			response.append(buffer, got);
+		}
+		::close(socket);
+
+		return true;
+	}
+
+	// the text exposition format, strictly: HELP and TYPE before a family's samples, known types, counters named
+	// _total, and every sample a name, optional labels and a number. Samples are keyed by name and labels as written
+	bool parseExposition(const std::string& body, std::map< std::string, double >& samples)
+	{
+		std::map< std::string, std::string > types;
+		std::map< std::string, bool > helped;
+		std::istringstream lines(body);
+		std::string line;
+		while ( std::getline(lines, line) )
+		{
+			if ( line.compare(0, 7, "# HELP ") == 0 )
+			{
+				std::string name = line.substr(7, line.find(' ', 7) - 7);
+				helped[name] = true;
+				continue;
+			}
+			if ( line.compare(0, 7, "# TYPE ") == 0 )
+			{
+				size_t space = line.find(' ', 7);
+				std::string name = line.substr(7, space - 7);
+				std::string type = line.substr(space + 1);
+				if ( !helped[name] || types.count(name) || (type != "gauge" && type != "counter") )
+				{
+					return false;
+				}
+				bool total = name.size() > 6 && name.compare(name.size() - 6, 6, "_total") == 0;
+				if ( type == "counter" && !total )
+				{
+					return false;
+				}
+				types[name] = type;
+				continue;
+			}
+			size_t space = line.rfind(' ');
+			if ( line.empty() || line[0] == '#' || space == std::string::npos )
+			{
+				return false;
+			}
+			std::string key = line.substr(0, space);
+			std::string name = key.substr(0, key.find('{'));
+			if ( !types.count(name) || samples.count(key) )
+			{
+				return false;
+			}
+			if ( key.find('{') != std::string::npos && (key.back() != '}' || key.find("=\"") == std::string::npos) )
+			{
+				return false;
+			}
+			char* end = nullptr;
+			std::string value = line.substr(space + 1);
+			samples[key] = strtod(value.c_str(), &end);
+			if ( value.empty() || *end != '\0' )
+			{
+				return false;
+			}
+		}
+
+		return !samples.empty();
+	}
+
+	// the game's entities, from the per tag gauges
+	double liveEntities(const std::map< std::string, double >& samples)
+	{
+		double live = 0;
+		for (auto& entry : samples)
+		{
+			if ( entry.first.compare(0, 23, "shape_wars_entities{tag") == 0 && entry.first != "shape_wars_entities{tag=\"Background\"}" )
+			{
+				live += entry.second;
+			}
+		}
+
+		return live;
+	}
+}
+
+// a scraper stand-in against a running game: fetch /metrics, parse every line and check the numbers against the game
+TEST(metrics_scrape_parses)
+{
+	const uint16_t PORT = 47392;
+	Game game("config.json", true, 5);
+	if ( !game.metrics(PORT) )
+	{
+		SKIP("could not bind the metrics port");
+	}
+	for (int i = 0; i < 200; i++)
+	{
+		game.run();
+	}
+	// a scenario replaces the world, whatever was in it counts as despawned
+	ScenarioConfig scenario;
+	CHECK(parse_scenario(scenario, "scenarios/explosions.json", 0.1f));
+	game.loadScenario(scenario);
+	for (int i = 0; i < 100; i++)
+	{
+		game.run();
+	}
+	// the game publishes at most every METRICS_INTERVAL_MS, at the start of a frame
+	std::this_thread::sleep_for(std::chrono::milliseconds(METRICS_INTERVAL_MS + 50));
+	size_t ticks = game.ticks();
+	int score = game.score();
+	size_t entities = game.entityCount();
+	game.run();
+
+	std::string response;
+	CHECK(scrape(PORT, "/metrics", response));
+	CHECK(response.compare(0, 15, "HTTP/1.1 200 OK") == 0);
+	CHECK(response.find("Content-Type: text/plain; version=0.0.4\r\n") != std::string::npos);
+	size_t header = response.find("\r\n\r\n");
+	CHECK(header != std::string::npos);
+	std::string body = response.substr(header + 4);
+	CHECK(response.find("Content-Length: " + std::to_string(body.size()) + "\r\n") != std::string::npos);
+	std::map< std::string, double > samples;
+	CHECK(parseExposition(body, samples));
+
+	CHECK(samples["shape_wars_ticks_total"] == ticks);
+	CHECK(samples["shape_wars_score"] == score);
+	double live = liveEntities(samples);
+	CHECK(live == entities);
+	CHECK(samples["shape_wars_spawned_total"] - samples["shape_wars_despawned_total"] == live);
+	CHECK(samples["shape_wars_spawned_total"] > live);
+	CHECK(samples.count("shape_wars_frame_seconds{quantile=\"0.99\"}"));
+	CHECK(samples.count("shape_wars_system_seconds{system=\"collision\"}"));
+	// the tests always count allocations, and a busy frame allocates
+	CHECK(samples["shape_wars_allocations_per_frame"] > 0);
+
+	CHECK(scrape(PORT, "/", response));
+	CHECK(response.compare(0, 22, "HTTP/1.1 404 Not Found") == 0);
+	game.cleanup();
+}
+
+// rolling back undoes ticks that get simulated again, their spawns and despawns mustn't be counted twice
+TEST(metrics_count_rolled_back_ticks_once)
+{
+	const uint16_t PORT = 47393;
+	const uint16_t METRICS = 47394;
+	const size_t TICKS = 600;
+	Game host("config.json", true, 1);
+	if ( !host.host(PORT) || !host.metrics(METRICS) )
+	{
+		SKIP("could not bind the loopback or metrics port");
+	}
+	LoopbackBot bot(PORT, host.getConfig().window.fps, 0.1, 5);
+	bot.start();
+	Rng rng(50, 0);
+	InputFrame local;
+	while ( GameTests::netTick(host) < TICKS )
+	{
+		while ( GameTests::netTick(host) >= GameTests::session(host).confirmed() + 30 )
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			GameTests::session(host).poll();
+		}
+		if ( rng.range(0, 9) == 0 )
+		{
+			local.buttons = (uint8_t)(rng.next() & ~INPUT_PAUSE);
+			local.mouseX = (local.held(INPUT_SHOOT)) ? rng.range(0, 1279) : 0;
+			local.mouseY = (local.held(INPUT_SHOOT)) ? rng.range(0, 719) : 0;
+		}
+		GameTests::netStep(host, local);
+	}
+	CHECK(GameTests::rollbacks(host) > 0);
+	std::this_thread::sleep_for(std::chrono::milliseconds(METRICS_INTERVAL_MS + 50));
+	size_t entities = host.entityCount();
+	host.run(); // publishes first, then waits on the bot for its tick
+	bot.stop();
+
+	std::string response;
+	CHECK(scrape(METRICS, "/metrics", response));
+	size_t header = response.find("\r\n\r\n");
+	std::map< std::string, double > samples;
+	CHECK(header != std::string::npos && parseExposition(response.substr(header + 4), samples));
+	double live = liveEntities(samples);
+	CHECK(live == entities);
+	CHECK(samples["shape_wars_spawned_total"] - samples["shape_wars_despawned_total"] == live);
+	host.cleanup();
+}
@@ -0,0 +1,68 @@
+#include "Test.h"
+#include "GameTests.h"
+
+namespace
+{
+	std::vector< uint8_t > encoded(const WorldState& state)
+	{
+		ByteWriter out;
+		encodeWorld(state, out);
+
+		return out.data();
+	}
+}
+
+// a host playing a loopback bot whose input arrives late keeps guessing wrong and rolling back. Once every input up
+// to some tick is confirmed, its world at that tick must be exactly what simulating the confirmed inputs straight
+// through, with no guesses at all, gives
+TEST(rollback_matches_straight_simulation)
+{
+	const size_t TICKS = 240;
+	const uint16_t PORT = 47391;
+	const size_t LEAD = 30; // ticks, the bot's input is 6 late
+	Game host("config.json", true, 1);
+	if ( !host.host(PORT) )
+	{
+		SKIP("could not bind the loopback port");
+	}
+	LoopbackBot bot(PORT, host.getConfig().window.fps, 0.1, 5);
+	bot.start();
+	Rng rng(77, 0);
+	InputFrame local;
+	// past TICKS until the bot's input for all of them is in, so every wrong guess before it has been rolled back.
+	// Kept a little ahead of the bot rather than the whole history ahead, so TICKS can still be rewound to at the end
+	while ( GameTests::netTick(host) < TICKS || GameTests::session(host).confirmed() < TICKS )
+	{
+		while ( GameTests::netTick(host) >= GameTests::session(host).confirmed() + LEAD )
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			GameTests::session(host).poll();
+		}
+		if ( rng.range(0, 9) == 0 )
+		{
+			local.buttons = (uint8_t)(rng.next() & ~INPUT_PAUSE);
+			local.mouseX = (local.held(INPUT_SHOOT)) ? rng.range(0, 1279) : 0;
+			local.mouseY = (local.held(INPUT_SHOOT)) ? rng.range(0, 719) : 0;
+		}
+		GameTests::netStep(host, local);
+	}
+	bot.stop();
+	CHECK(GameTests::rollbacks(host) > 0);
+	WorldState rolledBack;
+	CHECK(GameTests::netState(host, TICKS, rolledBack));
+
+	NetSession& session = GameTests::session(host);
+	Game straight("config.json", true, 2);
+	GameTests::startLocal(straight, session.seed());
+	for (size_t t = 0; t < TICKS; t++)
+	{
+		GameTests::step(straight, session.local(t), session.remote(t));
+	}
+	WorldState expected;
+	straight.captureState(expected);
+	CHECK(rolledBack.currentFrame == expected.currentFrame);
+	CHECK(rolledBack.world.entities.size() == expected.world.entities.size());
+	CHECK(encoded(rolledBack) == encoded(expected));
+	host.cleanup();
+	straight.cleanup();
+}
@@ -0,0 +1,220 @@
+#include "Test.h"
+#include "../PolyBatch.h"
+#include "../SoftwareRenderer.h"
+#include "../Game.h"
+#include "rlgl.h"
+#include <fstream>
+#include <stdlib.h>
+
+namespace
+{
+	const int WIDTH = 320;
+	const int HEIGHT = 240;
+
+	// rotated, outlined and translucent shapes of every common side count. None overlap, the batch draws them grouped
+	// by side count rather than in snapshot order
+	RenderSnapshot scene()
+	{
+		RenderSnapshot frame;
+		frame.background = (Color) {15, 20, 10, 255};
+		const int sides[] = {3, 4, 5, 6, 8};
+		for (int i = 0; i < 5; i++)
+		{
+			float x = 35 + i * 60;
+			frame.addShape((Vector2) {x, 70}, i * 17.0f, sides[i], 24, (Color) {(unsigned char)(60 * i), 120, 200, 255}, WHITE, 2);
+			frame.addShape((Vector2) {x + 10, 160}, i * 31.0f, sides[i], 26, (Color) {230, (unsigned char)(40 * i), 60, 160}, (Color) {255, 0, 0, 255}, 1);
+		}
+
+		return frame;
+	}
+
+	// P6 with a maxval of 255, as SoftwareRenderer::savePPM writes them
+	bool readPPM(const std::string& file, int& width, int& height, std::vector< Color >& pixels)
+	{
+		std::ifstream input(file, std::ios::binary);
+		std::string magic;
+		int maxval = 0;
+		if ( !(input >> magic >> width >> height >> maxval) || magic != "P6" || maxval != 255 )
+		{
+			return false;
+		}
+		input.get();
+		std::vector< unsigned char > rgb(width * height * 3);
+		if ( !input.read((char*)rgb.data(), rgb.size()) )
+		{
+			return false;
+		}
+		pixels.resize(width * height);
+		for (int i = 0; i < width * height; i++)
+		{
+			pixels[i] = (Color) {rgb[i * 3], rgb[i * 3 + 1], rgb[i * 3 + 2], 255};
+		}
+
+		return true;
+	}
+
+	bool same(const Color& a, const Color& b, int tolerance)
+	{
+		return abs(a.r - b.r) <= tolerance && abs(a.g - b.g) <= tolerance && abs(a.b - b.b) <= tolerance;
+	}
+
+	// the stress scenarios' scale, 20k shapes of each side count with outlines 1 and 2 pixels wide
+	RenderSnapshot crowd(size_t& vertices)
+	{
+		RenderSnapshot frame;
+		const int sides[] = {3, 4, 5, 6, 8};
+		vertices = 0;
+		for (int i = 0; i < 100000; i++)
+		{
+			int s = sides[i % 5];
+			int outline = 1 + i % 2;
+			frame.addShape((Vector2) {(float)(i % WIDTH), (float)(i / WIDTH % HEIGHT)}, i, s, 4, WHITE, RED, outline);
+			vertices += 3 * s + 2 * s * outline;
+		}
+
+		return frame;
+	}
+}
+
+// PolyBatch draws as many batches as it plans, so the plan is what a big scene costs. It has to flush every time
+// rlgl's buffer fills, far more than two batches per side count, and far fewer than one per shape
+TEST(poly_batch_flushes_at_scale)
+{
+	PolyBatch batch;
+	CHECK(batch.plan(scene().shapes) == 10);
+	size_t vertices = 0;
+	RenderSnapshot frame = crowd(vertices);
+	size_t batches = batch.plan(frame.shapes);
+	size_t full = vertices / PolyBatch::BATCH_VERTICES;
+	CHECK(batches > 100);
+	CHECK(batches >= 10 + full);
+	CHECK(batches <= 10 + full + full / 10);
+}
+
+// the batched GPU path against the CPU rasterizer, which draws the same vertices. Needs a display, which on a machine
+// without a GPU can be Xvfb with Mesa's llvmpipe, and skips without one
+TEST(poly_batch_matches_software_renderer)
+{
+	if ( !getenv("DISPLAY") && !getenv("WAYLAND_DISPLAY") )
+	{
+		SKIP("no display");
+	}
+	SetConfigFlags(FLAG_WINDOW_HIDDEN);
+	InitWindow(WIDTH, HEIGHT, "shape_wars_tests");
+	if ( !IsWindowReady() )
+	{
+		SKIP("could not open a window");
+	}
+	RenderSnapshot frame = scene();
+	PolyBatch batch;
+	BeginDrawing();
+	ClearBackground(frame.background);
+	batch.draw(frame.shapes);
+	rlglDraw();
+	Image screen = GetScreenData();
+	EndDrawing();
+	// one fill and one outline batch per side count, nothing near full
+	CHECK(batch.batches == 10);
+
+	SoftwareRenderer cpu(WIDTH, HEIGHT, 20, BLANK);
+	cpu.draw(frame);
+	const unsigned char* gpu = (const unsigned char*)screen.data;
+	int differing = 0;
+	for (int i = 0; i < WIDTH * HEIGHT; i++)
+	{
+		Color pixel = {gpu[i * 4], gpu[i * 4 + 1], gpu[i * 4 + 2], 255};
+		differing += ( !same(pixel, cpu.pixels()[i], 8) ) ? 1 : 0;
+	}
+	// the rasterizers only disagree along edges, and about how GL_LINES end
+	CHECK(differing < WIDTH * HEIGHT / 50);
+	for (const ShapeInstance& shape : frame.shapes)
+	{
+		int i = (int)shape.pos.y * WIDTH + (int)shape.pos.x;
+		Color pixel = {gpu[i * 4], gpu[i * 4 + 1], gpu[i * 4 + 2], 255};
+		CHECK(same(pixel, cpu.pixels()[i], 2));
+	}
+	UnloadImage(screen);
+
+	size_t vertices = 0;
+	RenderSnapshot big = crowd(vertices);
+	BeginDrawing();
+	batch.draw(big.shapes);
+	EndDrawing();
+	CHECK(batch.batches == batch.plan(big.shapes));
+	CloseWindow();
+}
+
+// the CPU rasterizer against a committed image of the same scene, HUD and a label included. Run with
+// UPDATE_REFERENCES=1 to rewrite tests/reference/scene.ppm after a deliberate change to how things are drawn
+TEST(software_renderer_matches_reference)
+{
+	RenderSnapshot frame = scene();
+	frame.score = 1230;
+	frame.highScore = 4560;
+	frame.seconds = 78;
+	frame.addLabel((Vector2) {110, 205}, "PAUSED", 20, (Color) {255, 255, 255, 200});
+	SoftwareRenderer cpu(WIDTH, HEIGHT, 20, WHITE, 4);
+	cpu.draw(frame);
+	const char* reference = "tests/reference/scene.ppm";
+	if ( getenv("UPDATE_REFERENCES") )
+	{
+		CHECK(cpu.savePPM(reference));
+	}
+	int width = 0;
+	int height = 0;
+	std::vector< Color > expected;
+	CHECK(readPPM(reference, width, height, expected));
+	CHECK(width == WIDTH && height == HEIGHT);
+	if ( expected.size() != cpu.pixels().size() )
+	{
+		return;
+	}
+	// a compiler that rounds differently can move a few pixels along an edge, nothing more
+	int differing = 0;
+	for (size_t i = 0; i < expected.size(); i++)
+	{
+		differing += ( !same(expected[i], cpu.pixels()[i], 0) ) ? 1 : 0;
+	}
+	CHECK(differing <= WIDTH * HEIGHT / 1000);
+
+	// tiles are independent, so any number of threads draws the same image, and so does the file written out
+	SoftwareRenderer single(WIDTH, HEIGHT, 20, WHITE, 1);
+	single.draw(frame);
+	std::string file = testDir() + "/scene.ppm";
+	CHECK(single.savePPM(file.c_str()));
+	std::vector< Color > written;
+	CHECK(readPPM(file, width, height, written));
+	for (size_t i = 0; i < written.size(); i++)
+	{
+		CHECK(same(written[i], cpu.pixels()[i], 0));
+		if ( testState().failures )
+		{
+			break;
+		}
+	}
+}
+
+// what --frames does, a headless game drawn on the CPU
+TEST(headless_game_draws_on_cpu)
+{
+	Game game("config.json", true, 7);
+	for (int i = 0; i < 30; i++)
+	{
+		game.run();
+	}
+	const GameConfig& config = game.getConfig();
+	SoftwareRenderer cpu(config.window.width, config.window.height, config.font.size, config.font.col);
+	game.draw(cpu);
+	size_t background = 0;
+	size_t text = 0;
+	for (const Color& pixel : cpu.pixels())
+	{
+		background += ( same(pixel, config.window.col, 0) ) ? 1 : 0;
+		text += ( same(pixel, config.font.col, 0) ) ? 1 : 0;
+	}
+	// mostly background, with the players, enemies and HUD on top
+	CHECK(background > cpu.pixels().size() / 2);
+	CHECK(background < cpu.pixels().size());
+	CHECK(text > 0);
+	game.cleanup();
+}
@@ -0,0 +1,89 @@
+#include "Test.h"
+#include "../Game.h"
+
+namespace
+{
+	// the whole world at the end of a headless replay, encoded
+	std::vector< uint8_t > replayToEnd(Game& game)
+	{
+		while ( !game.replayFinished() )
+		{
+			game.run();
+		}
+		WorldState state;
+		game.captureState(state);
+		ByteWriter out;
+		encodeWorld(state, out);
+
+		return out.data();
+	}
+}
+
+// a session played from a log of random input and recorded as it goes, then the recording played back in a fresh
+// game, must end in exactly the same world
+TEST(replay_reproduces_recorded_session)
+{
+	const int TICKS = 1200;
+	std::string generated = testDir() + "/generated.replay";
+	std::string recorded = testDir() + "/recorded.replay";
+	std::vector< InputFrame > inputs(TICKS);
+	{
+		Game game("config.json", true, 1);
+		ReplayHeader header;
+		header.seed = 12345;
+		header.fps = game.getConfig().window.fps;
+		header.width = game.getConfig().window.width;
+		header.height = game.getConfig().window.height;
+		header.paused = false;
+		InputRecorder recorder;
+		CHECK(recorder.open(generated.c_str(), header));
+		// held for a few ticks at a time like real input, so the run length encoding gets exercised too
+		Rng rng(99, 0);
+		InputFrame input;
+		for (int i = 0; i < TICKS; i++)
+		{
+			if ( rng.range(0, 7) == 0 )
+			{
+				input.buttons = (uint8_t)(rng.next() & ~INPUT_PAUSE);
+				bool shooting = input.held(INPUT_SHOOT);
+				input.mouseX = (shooting) ? rng.range(0, header.width - 1) : 0;
+				input.mouseY = (shooting) ? rng.range(0, header.height - 1) : 0;
+			}
+			inputs[i] = input;
+			recorder.push(input);
+		}
+		recorder.close();
+		game.cleanup();
+	}
+
+	Game played("config.json", true, 2);
+	CHECK(played.replay(generated.c_str()));
+	CHECK(played.record(recorded.c_str()));
+	std::vector< uint8_t > expected = replayToEnd(played);
+	int score = played.score();
+	int frame = played.currentFrame();
+	CHECK(played.ticks() == TICKS);
+	played.cleanup();
+
+	// the recording holds the same ticks as the log it was played from
+	InputPlayback playback;
+	CHECK(playback.open(recorded.c_str()));
+	CHECK(playback.header().seed == 12345);
+	InputFrame input;
+	int ticks = 0;
+	while ( playback.next(input) )
+	{
+		CHECK(ticks < TICKS && input == inputs[ticks]);
+		ticks++;
+	}
+	CHECK(ticks == TICKS);
+
+	Game replayed("config.json", true, 3);
+	CHECK(replayed.replay(recorded.c_str()));
+	std::vector< uint8_t > actual = replayToEnd(replayed);
+	CHECK(replayed.score() == score);
+	CHECK(replayed.currentFrame() == frame);
+	CHECK(replayed.ticks() == TICKS);
+	CHECK(actual == expected);
+	replayed.cleanup();
+}
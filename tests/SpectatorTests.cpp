@@ -0,0 +1,128 @@
+#include "Test.h"
+#include "../Spectator.h"
+#include "../Random.h"
+#include <map>
+#include <string.h>
+
+namespace
+{
+	SpecEntity randomEntity(Rng& rng, uint32_t id, uint8_t kind)
+	{
+		SpecFrame one;
+		Vector2 pos = {rng.uniform(-50, 1330), rng.uniform(-50, 770)};
+		Color fill = {(unsigned char)rng.range(0, 255), (unsigned char)rng.range(0, 255), (unsigned char)rng.range(0, 255), (unsigned char)rng.range(0, 255)};
+		if ( kind == SPEC_SHAPE )
+		{
+			Color outline = {(unsigned char)rng.range(0, 255), (unsigned char)rng.range(0, 255), (unsigned char)rng.range(0, 255), 255};
+			one.addShape(id, pos, rng.uniform(-720, 720), rng.range(3, 8), rng.uniform(2, 60), fill, outline, rng.range(0, 4));
+		}
+		else
+		{
+			one.addLabel(id, pos, rng.range(0, 5), rng.uniform(10, 80), fill);
+		}
+
+		return one.entities[0];
+	}
+
+	bool same(const SpecFrame& a, const SpecFrame& b)
+	{
+		if ( a.seq != b.seq || a.score != b.score || a.highScore != b.highScore || a.seconds != b.seconds || a.background != b.background || a.entities.size() != b.entities.size() )
+		{
+			return false;
+		}
+		for (size_t i = 0; i < a.entities.size(); i++)
+		{
+			const SpecEntity& x = a.entities[i];
+			const SpecEntity& y = b.entities[i];
+			if ( x.id != y.id || x.kind != y.kind || memcmp(x.fields, y.fields, sizeof(x.fields)) != 0 )
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
+
+// a random series of frames, each encoded against the one before it (now and then in full) the way the server sends
+// them, must decode on the viewer's side to exactly the frame that was sent
+TEST(spectator_deltas_round_trip)
+{
+	Rng rng(40, 0);
+	std::map< uint32_t, SpecEntity > world; // by id, so frames come out in id order
+	uint32_t nextId = 1;
+	SpecFrame previous;
+	SpecFrame viewer;
+	size_t bytes[2] = {0, 0}; // deltas, full frames
+	size_t frames[2] = {0, 0};
+	for (uint32_t seq = 1; seq <= 300; seq++)
+	{
+		// some leave, some change, a few come back as the other kind under the same id, and new ones arrive.
+		// Game entities get the top bit like sSpectate gives them
+		for (auto it = world.begin(); it != world.end(); )
+		{
+			int roll = rng.range(0, 99);
+			if ( roll < 5 )
+			{
+				it = world.erase(it);
+				continue;
+			}
+			if ( roll < 7 )
+			{
+				it->second = randomEntity(rng, it->first, (it->second.kind == SPEC_SHAPE) ? SPEC_LABEL : SPEC_SHAPE);
+			}
+			else if ( roll < 40 )
+			{
+				SpecEntity moved = randomEntity(rng, it->first, it->second.kind);
+				it->second.fields[SPEC_X] = moved.fields[SPEC_X];
+				it->second.fields[SPEC_Y] = moved.fields[SPEC_Y];
+				it->second.fields[SPEC_ROTATION] = moved.fields[SPEC_ROTATION];
+			}
+			it++;
+		}
+		for (int i = rng.range(0, 8); i > 0; i--)
+		{
+			uint32_t id = nextId++ | ((rng.range(0, 3) == 0) ? 0 : 0x80000000u);
+			world[id] = randomEntity(rng, id, (rng.range(0, 9) == 0) ? SPEC_LABEL : SPEC_SHAPE);
+		}
+		SpecFrame frame;
+		frame.seq = seq;
+		frame.score = rng.range(0, 5000) - 100;
+		frame.highScore = rng.range(0, 5000);
+		frame.seconds = seq / 60;
+		frame.background = rng.range(0, 255);
+		for (auto& entry : world)
+		{
+			frame.entities.push_back(entry.second);
+		}
+		bool full = seq == 1 || seq % 50 == 0;
+		ByteWriter out;
+		encodeSpecFrame((full) ? nullptr : &previous, frame, out);
+		bytes[full] += out.size();
+		frames[full]++;
+		ByteReader in(out.data());
+		CHECK(decodeSpecFrame(in, viewer));
+		CHECK(in.done());
+		CHECK(same(viewer, frame));
+		if ( testState().failures )
+		{
+			std::cout << "    on frame " << seq << std::endl;
+			return;
+		}
+		previous = frame;
+	}
+	// deltas of a mostly still world are much smaller than sending it all
+	CHECK(bytes[0] / frames[0] < bytes[1] / frames[1] / 2);
+
+	// a delta against a frame the viewer doesn't have is refused, and leaves the viewer's frame alone
+	SpecFrame older = previous;
+	older.seq = previous.seq - 1;
+	SpecFrame next = previous;
+	next.seq = previous.seq + 1;
+	next.entities.pop_back();
+	ByteWriter out;
+	encodeSpecFrame(&older, next, out);
+	ByteReader in(out.data());
+	CHECK(!decodeSpecFrame(in, viewer));
+	CHECK(same(viewer, previous));
+}
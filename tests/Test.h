@@ -0,0 +1,54 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+// a minimal test harness for `make test`. TEST(name) registers a function run by tests/main.cpp, CHECK(cond) records
+// a failure with its file and line and keeps going, SKIP(why) ends the test early without failing it
+struct TestCase
+{
+	const char* name;
+	void (*run)();
+};
+
+struct TestState
+{
+	int failures = 0; // in the running test
+	const char* skipped = nullptr; // why the running test was skipped
+};
+
+std::vector< TestCase >& testCases();
+TestState& testState();
+// a scratch directory for the running test's files, emptied before every test
+std::string testDir();
+
+struct TestRegistrar
+{
+	TestRegistrar(const char* name, void (*run)())
+	{
+		testCases().push_back((TestCase) {name, run});
+	}
+};
+
+#define TEST(name) \
+	static void test_##name(); \
+	static TestRegistrar registrar_##name(#name, &test_##name); \
+	static void test_##name()
+
+#define CHECK(cond) \
+	do \
+	{ \
+		if ( !(cond) ) \
+		{ \
+			testState().failures++; \
+			std::cout << "    " << __FILE__ << ":" << __LINE__ << ": CHECK(" #cond ") failed" << std::endl; \
+		} \
+	} while (0)
+
+#define SKIP(why) \
+	do \
+	{ \
+		testState().skipped = why; \
+		return; \
+	} while (0)
@@ -0,0 +1,65 @@
+#include "Test.h"
+#include "../Log.h"
+#include <filesystem>
+#include <string.h>
+
+// runs every registered test, or those whose name contains the first argument, from the directory with config.json.
+// Exits with 1 if any failed
+std::vector< TestCase >& testCases()
+{
+	static std::vector< TestCase > cases;
+	return cases;
+}
+
+TestState& testState()
+{
+	static TestState state;
+	return state;
+}
+
+std::string testDir()
+{
+	return (std::filesystem::temp_directory_path() / "shape_wars_tests").string();
+}
+
+int main(int argc, char* argv[])
+{
+	const char* filter = (argc > 1) ? argv[1] : nullptr;
+	int passed = 0;
+	int failed = 0;
+	int skipped = 0;
+	for (const TestCase& test : testCases())
+	{
+		if ( filter && !strstr(test.name, filter) )
+		{
+			continue;
+		}
+		std::error_code error;
+		std::filesystem::remove_all(testDir(), error);
+		std::filesystem::create_directories(testDir(), error);
+		testState() = TestState();
+		std::cout << "[ RUN  ] " << test.name << std::endl;
+		test.run();
+		if ( testState().failures )
+		{
+			std::cout << "[ FAIL ] " << test.name << std::endl;
+			failed++;
+		}
+		else if ( testState().skipped )
+		{
+			std::cout << "[ SKIP ] " << test.name << ": " << testState().skipped << std::endl;
+			skipped++;
+		}
+		else
+		{
+			std::cout << "[  OK  ] " << test.name << std::endl;
+			passed++;
+		}
+	}
+	std::error_code error;
+	std::filesystem::remove_all(testDir(), error);
+	logFlush();
+	std::cout << passed << " passed, " << failed << " failed, " << skipped << " skipped" << std::endl;
+
+	return (failed) ? 1 : 0;
+}